@@ -1,5 +1,6 @@
 #pragma once
 #include <cassert>
+#include <cstdint>
 #include <SDL_keyboard.h>
 #include <SDL_mouse.h>
 
@@ -30,6 +31,9 @@ namespace dae
 		bool hasMoved{ true };
 		bool hasChangedFov{ true };
 
+		//Incremented whenever the view or projection matrix is recalculated
+		uint32_t matrixVersion{};
+
 		Vector3 forward{Vector3::UnitZ};
 		Vector3 up{Vector3::UnitY};
 		Vector3 right{Vector3::UnitX};
@@ -67,6 +71,7 @@ namespace dae
 			up = invViewMatrix.GetAxisY();
 
 			hasMoved = false;
+			++matrixVersion;
 			//DirectX Implementation => https://learn.microsoft.com/en-us/windows/win32/direct3d9/d3dxmatrixlookatlh
 		}
 
@@ -75,6 +80,7 @@ namespace dae
 			projectionMatrix = Matrix::CreatePerspectiveFovLH(fov, aspectRatio, nearPlane, farPlane);
 			 
 			hasChangedFov = false;
+			++matrixVersion;
 			//DirectX Implementation => https://learn.microsoft.com/en-us/windows/win32/direct3d9/d3dxmatrixperspectivefovlh
 		}
 
@@ -22,6 +22,10 @@ namespace dae
 		Vector3 normal{};
 		Vector3 tangent{};
 		Vector3 viewDirection{};
+
+		//Change of uv towards the next pixel in x and y, shared by the 2x2 pixel quad like on a GPU
+		Vector2 uvDerivativeX{};
+		Vector2 uvDerivativeY{};
 	};
 
 	enum class PrimitiveTopology
@@ -30,13 +34,83 @@ namespace dae
 		TriangleStrip
 	};
 
+	//Positions, normals and tangents with one array per component, the input of the batched vertex transform
+	struct VertexStreams
+	{
+		std::vector<float> positionX{};
+		std::vector<float> positionY{};
+		std::vector<float> positionZ{};
+		std::vector<float> normalX{};
+		std::vector<float> normalY{};
+		std::vector<float> normalZ{};
+		std::vector<float> tangentX{};
+		std::vector<float> tangentY{};
+		std::vector<float> tangentZ{};
+	};
+
+	//A cluster of neighbouring triangles that is culled as a whole before its vertices are transformed
+	struct Meshlet
+	{
+		//Triangles [firstIndex, firstIndex + nrIndices) of the mesh, using the vertices [firstVertex, firstVertex + nrVertices) of Mesh::meshletVertices
+		uint32_t firstIndex{};
+		uint32_t nrIndices{};
+		uint32_t firstVertex{};
+		uint32_t nrVertices{};
+
+		//Object space bounding sphere
+		Vector3 center{};
+		float radius{};
+
+		//Every face normal is within the cone around the axis, back facing from wherever the view direction is within the cutoff
+		//A cutoff of 1 never culls
+		Vector3 coneAxis{};
+		float coneCutoff{ 1.f };
+	};
+
+	//One level of detail, all levels share the vertices of the mesh
+	struct MeshLod
+	{
+		//Triangles [firstIndex, firstIndex + nrIndices) of the mesh, split into the meshlets [firstMeshlet, firstMeshlet + nrMeshlets)
+		uint32_t firstIndex{};
+		uint32_t nrIndices{};
+		uint32_t firstMeshlet{};
+		uint32_t nrMeshlets{};
+
+		//Largest distance in object space the simplified surface is off from the full one
+		float error{};
+	};
+
 	struct Mesh
 	{
 		std::vector<Vertex> vertices{};
+		VertexStreams vertexStreams{}; //Copy of vertices, rebuilt whenever they change
 		std::vector<uint32_t> indices{};
 		PrimitiveTopology primitiveTopology{ PrimitiveTopology::TriangleList };
 
-		std::vector<Vertex_Out> vertices_out{};
+		//Empty for meshes that are drawn as a whole, otherwise level 0 is the full mesh and every next level has fewer triangles
+		std::vector<MeshLod> lods{};
+		size_t lodIndex{}; //Level picked the last time the vertices were transformed
+
+		//Object space bounding sphere of the whole mesh
+		Vector3 boundingCenter{};
+		float boundingRadius{};
+
+		std::vector<Meshlet> meshlets{};
+		std::vector<uint32_t> meshletVertices{};
+		std::vector<uint32_t> visibleMeshlets{}; //Indices of the meshlets that passed culling the last time the vertices were transformed
+
+		//Transformed vertices, one stream per attribute
+		//Positions (raster x and y, NDC depth and 1/w) are all that culling, setup and the depth test read,
+		//the other streams are only fetched for pixels that get shaded
+		std::vector<Vector4> positions_out{};
+		std::vector<Vector3> normals_out{};
+		std::vector<Vector3> tangents_out{};
+		std::vector<Vector3> viewDirections_out{};
+
+		std::vector<Vector4> positions_clip{}; //Before the perspective divide, for clipping
 		Matrix worldMatrix{};
+
+		//Set when the vertices or the world matrix changed since the vertices were last transformed
+		bool isTransformDirty{ true };
 	};
 }
\ No newline at end of file
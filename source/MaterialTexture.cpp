@@ -0,0 +1,109 @@
+#include "MaterialTexture.h"
+
+namespace dae
+{
+	MaterialTexture* MaterialTexture::Create(const Texture& diffuse, const Texture& normal, const Texture& gloss, const Texture& specular, TextureLayout layout)
+	{
+		const MipLevel& size{ diffuse.GetLevel(0) };
+
+		for (const Texture* pTexture : { &normal, &gloss, &specular })
+		{
+			if (pTexture->GetLevel(0).width != size.width || pTexture->GetLevel(0).height != size.height)
+				return nullptr;
+		}
+
+		//Equal sizes give equal mip chains
+		MaterialTexture* pMaterial{ new MaterialTexture() };
+
+		for (size_t levelIndex{}; levelIndex < diffuse.GetNrLevels(); ++levelIndex)
+		{
+			pMaterial->m_Levels.push_back(CreateMipLevel(diffuse.GetLevel(levelIndex).width, diffuse.GetLevel(levelIndex).height, 1, pMaterial->m_Texels.size(), layout));
+			pMaterial->m_Texels.resize(pMaterial->m_Texels.size() + pMaterial->m_Levels.back().nrBlocks);
+
+			const MipLevel& level{ pMaterial->m_Levels.back() };
+
+			for (int y{}; y < level.height; ++y)
+			{
+				for (int x{}; x < level.width; ++x)
+				{
+					const Texture::Texel& diffuseTexel{ diffuse.GetTexel(levelIndex, x, y) };
+					const Texture::Texel& normalTexel{ normal.GetTexel(levelIndex, x, y) };
+					const Texture::Texel& specularTexel{ specular.GetTexel(levelIndex, x, y) };
+
+					Texel& texel{ pMaterial->m_Texels[level.GetBlockIndex(x, y)] };
+					texel.diffuse[0] = diffuseTexel.red;
+					texel.diffuse[1] = diffuseTexel.green;
+					texel.diffuse[2] = diffuseTexel.blue;
+					texel.normal[0] = normalTexel.red;
+					texel.normal[1] = normalTexel.green;
+					texel.normal[2] = normalTexel.blue;
+					texel.specular[0] = specularTexel.red;
+					texel.specular[1] = specularTexel.green;
+					texel.specular[2] = specularTexel.blue;
+
+					//The gloss map is grayscale, shading only ever read its red channel
+					texel.gloss = gloss.GetTexel(levelIndex, x, y).red;
+				}
+			}
+		}
+
+		return pMaterial;
+	}
+
+	MaterialSample MaterialTexture::ToSample(const Texel& texel)
+	{
+		return
+		{
+			{ ChannelToFloat[texel.diffuse[0]], ChannelToFloat[texel.diffuse[1]], ChannelToFloat[texel.diffuse[2]] },
+			{ ChannelToFloat[texel.normal[0]], ChannelToFloat[texel.normal[1]], ChannelToFloat[texel.normal[2]] },
+			{ ChannelToFloat[texel.specular[0]], ChannelToFloat[texel.specular[1]], ChannelToFloat[texel.specular[2]] },
+			ChannelToFloat[texel.gloss]
+		};
+	}
+
+	MaterialSample MaterialTexture::Sample(const Vector2& uv) const
+	{
+		//Same texel selection as Texture::Sample
+		const MipLevel& level{ m_Levels[0] };
+		return ToSample(GetTexel(0, GetNearestTexel(uv.x, level.width), GetNearestTexel(uv.y, level.height)));
+	}
+
+	MaterialSample MaterialTexture::Sample(const Vector2& uv, const Vector2& uvDerivativeX, const Vector2& uvDerivativeY) const
+	{
+		//Same level selection and weights as Texture::Sample
+		const float level{ std::min(GetMipLevel(uvDerivativeX, uvDerivativeY, m_Levels[0].width, m_Levels[0].height), static_cast<float>(m_Levels.size() - 1)) };
+		const size_t level0{ static_cast<size_t>(level) };
+		const float fraction{ level - level0 };
+
+		MaterialSample sample{};
+		AddBilinear(uv, level0, 1.f - fraction, sample);
+		if (fraction > 0.f)
+			AddBilinear(uv, level0 + 1, fraction, sample);
+
+		return sample;
+	}
+
+	void MaterialTexture::AddBilinear(const Vector2& uv, size_t level, float levelWeight, MaterialSample& sample) const
+	{
+		const BilinearFootprint footprint{ GetBilinearFootprint(uv, m_Levels[level].width, m_Levels[level].height, levelWeight) };
+
+		AddTexel(GetTexel(level, footprint.x0, footprint.y0), footprint.weight00, sample);
+		AddTexel(GetTexel(level, footprint.x1, footprint.y0), footprint.weight10, sample);
+		AddTexel(GetTexel(level, footprint.x0, footprint.y1), footprint.weight01, sample);
+		AddTexel(GetTexel(level, footprint.x1, footprint.y1), footprint.weight11, sample);
+	}
+
+	void MaterialTexture::AddTexel(const Texel& texel, float weight, MaterialSample& sample)
+	{
+		sample.diffuse.m_pRed += ChannelToFloat[texel.diffuse[0]] * weight;
+		sample.diffuse.m_pGreen += ChannelToFloat[texel.diffuse[1]] * weight;
+		sample.diffuse.m_pBlue += ChannelToFloat[texel.diffuse[2]] * weight;
+		sample.normal.m_pRed += ChannelToFloat[texel.normal[0]] * weight;
+		sample.normal.m_pGreen += ChannelToFloat[texel.normal[1]] * weight;
+		sample.normal.m_pBlue += ChannelToFloat[texel.normal[2]] * weight;
+		sample.specular.m_pRed += ChannelToFloat[texel.specular[0]] * weight;
+		sample.specular.m_pGreen += ChannelToFloat[texel.specular[1]] * weight;
+		sample.specular.m_pBlue += ChannelToFloat[texel.specular[2]] * weight;
+		sample.gloss += ChannelToFloat[texel.gloss] * weight;
+	}
+}
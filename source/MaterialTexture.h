@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "ColorRGB.h"
+#include "Texture.h"
+
+namespace dae
+{
+	//Every surface input PixelShading reads for one texel
+	struct MaterialSample
+	{
+		ColorRGB diffuse{};
+		ColorRGB normal{}; //Normal map value, still in [0, 1]
+		ColorRGB specular{};
+		float gloss{};
+	};
+
+	//Diffuse, normal, specular and gloss maps interleaved per texel, shading a pixel fetches one record instead of four texels from four images
+	class MaterialTexture
+	{
+	public:
+		~MaterialTexture() = default;
+
+		//All maps must have the same size, returns nullptr otherwise
+		static MaterialTexture* Create(const Texture& diffuse, const Texture& normal, const Texture& gloss, const Texture& specular, TextureLayout layout = TextureLayout::Morton);
+
+		//Same values as sampling every map on its own, nearest texel of level 0 or trilinear
+		MaterialSample Sample(const Vector2& uv) const;
+		MaterialSample Sample(const Vector2& uv, const Vector2& uvDerivativeX, const Vector2& uvDerivativeY) const;
+
+		//Texel storage of all levels, in bytes
+		size_t GetMemorySize() const { return m_Texels.size() * sizeof(Texel); }
+
+	private:
+		MaterialTexture() = default;
+
+		//10 bytes without padding, aligning to 16 would fetch 60% more bytes for the same texels
+		//The normal keeps its Z channel, the map is not unit length so reconstructing Z from XY would change the shading
+		struct Texel
+		{
+			uint8_t diffuse[3]{};
+			uint8_t normal[3]{};
+			uint8_t specular[3]{};
+			uint8_t gloss{};
+		};
+
+		//Every level of the maps' mip chains is packed
+		std::vector<MipLevel> m_Levels{};
+		std::vector<Texel> m_Texels{};
+
+		const Texel& GetTexel(size_t level, int x, int y) const { return m_Texels[m_Levels[level].GetBlockIndex(x, y)]; }
+		static MaterialSample ToSample(const Texel& texel);
+		void AddBilinear(const Vector2& uv, size_t level, float levelWeight, MaterialSample& sample) const;
+		static void AddTexel(const Texel& texel, float weight, MaterialSample& sample);
+	};
+}
@@ -0,0 +1,703 @@
+#include "MeshOptimizer.h"
+
+//Standard includes
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+namespace dae
+{
+	namespace MeshOptimizer
+	{
+		namespace
+		{
+			void CalculateBounds(const Mesh& mesh, Meshlet& meshlet)
+			{
+				//Sphere around the center of the bounding box
+				Vector3 minimum{ mesh.vertices[mesh.meshletVertices[meshlet.firstVertex]].position };
+				Vector3 maximum{ minimum };
+				for (uint32_t vertex{ meshlet.firstVertex }; vertex < meshlet.firstVertex + meshlet.nrVertices; ++vertex)
+				{
+					const Vector3& position{ mesh.vertices[mesh.meshletVertices[vertex]].position };
+					for (int axis{}; axis < 3; ++axis)
+					{
+						minimum[axis] = std::min(minimum[axis], position[axis]);
+						maximum[axis] = std::max(maximum[axis], position[axis]);
+					}
+				}
+
+				meshlet.center = (minimum + maximum) * 0.5f;
+				meshlet.radius = 0.f;
+				for (uint32_t vertex{ meshlet.firstVertex }; vertex < meshlet.firstVertex + meshlet.nrVertices; ++vertex)
+				{
+					meshlet.radius = std::max(meshlet.radius, (mesh.vertices[mesh.meshletVertices[vertex]].position - meshlet.center).Magnitude());
+				}
+
+				//Face normals in the winding that is front facing, they point to the side the triangle is visible from
+				std::vector<Vector3> normals{};
+				Vector3 normalSum{};
+				for (uint32_t index{ meshlet.firstIndex }; index < meshlet.firstIndex + meshlet.nrIndices; index += 3)
+				{
+					const Vector3& p0{ mesh.vertices[mesh.indices[index]].position };
+					const Vector3& p1{ mesh.vertices[mesh.indices[index + 1]].position };
+					const Vector3& p2{ mesh.vertices[mesh.indices[index + 2]].position };
+
+					const Vector3 normal{ Vector3::Cross(p1 - p0, p2 - p0) };
+					const float magnitude{ normal.Magnitude() };
+					if (magnitude <= 0.f) continue;
+
+					normals.push_back(normal / magnitude);
+					normalSum += normals.back();
+				}
+
+				meshlet.coneAxis = {};
+				meshlet.coneCutoff = 1.f;
+
+				const float sumMagnitude{ normalSum.Magnitude() };
+				if (sumMagnitude <= 0.f) return;
+
+				meshlet.coneAxis = normalSum / sumMagnitude;
+
+				float minDot{ 1.f };
+				for (const Vector3& normal : normals)
+				{
+					minDot = std::min(minDot, Vector3::Dot(meshlet.coneAxis, normal));
+				}
+
+				//A cone of 90 degrees or wider is front facing from every direction
+				if (minDot <= 0.f) return;
+
+				//Every normal is within acos(minDot) of the axis, the view direction has to be within 90 degrees minus that
+				meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+			}
+
+			//Sum of the squared distances to a set of planes, weighted by triangle area (Garland and Heckbert 1997)
+			struct Quadric
+			{
+				float a00{}, a11{}, a22{};
+				float a01{}, a02{}, a12{};
+				float b0{}, b1{}, b2{};
+				float c{};
+				float weight{};
+			};
+
+			void AddPlane(Quadric& quadric, const Vector3& normal, float distance, float weight)
+			{
+				quadric.a00 += normal.x * normal.x * weight;
+				quadric.a11 += normal.y * normal.y * weight;
+				quadric.a22 += normal.z * normal.z * weight;
+				quadric.a01 += normal.x * normal.y * weight;
+				quadric.a02 += normal.x * normal.z * weight;
+				quadric.a12 += normal.y * normal.z * weight;
+				quadric.b0 += normal.x * distance * weight;
+				quadric.b1 += normal.y * distance * weight;
+				quadric.b2 += normal.z * distance * weight;
+				quadric.c += distance * distance * weight;
+				quadric.weight += weight;
+			}
+
+			void AddQuadric(Quadric& quadric, const Quadric& other)
+			{
+				quadric.a00 += other.a00;
+				quadric.a11 += other.a11;
+				quadric.a22 += other.a22;
+				quadric.a01 += other.a01;
+				quadric.a02 += other.a02;
+				quadric.a12 += other.a12;
+				quadric.b0 += other.b0;
+				quadric.b1 += other.b1;
+				quadric.b2 += other.b2;
+				quadric.c += other.c;
+				quadric.weight += other.weight;
+			}
+
+			//Area weighted mean of the squared distances from p to the planes
+			float GetError(const Quadric& quadric, const Vector3& p)
+			{
+				if (quadric.weight <= 0.f)
+					return 0.f;
+
+				const float error
+				{
+					quadric.a00 * p.x * p.x + quadric.a11 * p.y * p.y + quadric.a22 * p.z * p.z +
+					2.f * (quadric.a01 * p.x * p.y + quadric.a02 * p.x * p.z + quadric.a12 * p.y * p.z) +
+					2.f * (quadric.b0 * p.x + quadric.b1 * p.y + quadric.b2 * p.z) +
+					quadric.c
+				};
+
+				return std::max(0.f, error / quadric.weight);
+			}
+
+			struct Collapse
+			{
+				uint32_t from{};
+				uint32_t to{};
+				float error{};
+			};
+
+			//Checks that moving position from onto position to keeps the attribute seams and does not flip a triangle
+			//Every vertex at from is assigned the vertex at to that it shares a triangle with, vertices on both sides of a seam need one each
+			bool CanCollapse(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& positions,
+				const uint32_t* pTriangles, size_t nrTriangles, uint32_t from, uint32_t to, std::vector<std::pair<uint32_t, uint32_t>>& wedgeMap)
+			{
+				wedgeMap.clear();
+
+				for (size_t triangle{}; triangle < nrTriangles; ++triangle)
+				{
+					const uint32_t* pCorners{ &indices[pTriangles[triangle] * 3] };
+
+					int fromCorner{ -1 };
+					int toCorner{ -1 };
+					for (int corner{}; corner < 3; ++corner)
+					{
+						if (positions[pCorners[corner]] == from) fromCorner = corner;
+						if (positions[pCorners[corner]] == to) toCorner = corner;
+					}
+
+					if (toCorner < 0) continue;
+
+					const std::pair<uint32_t, uint32_t> pair{ pCorners[fromCorner], pCorners[toCorner] };
+					for (const std::pair<uint32_t, uint32_t>& mapped : wedgeMap)
+					{
+						//One vertex going to two, or two going to one, would tear or weld a seam
+						if ((mapped.first == pair.first) != (mapped.second == pair.second))
+							return false;
+					}
+
+					wedgeMap.push_back(pair);
+				}
+
+				const Vector3& target{ vertices[to].position };
+				for (size_t triangle{}; triangle < nrTriangles; ++triangle)
+				{
+					const uint32_t* pCorners{ &indices[pTriangles[triangle] * 3] };
+
+					int fromCorner{ -1 };
+					bool hasTo{ false };
+					for (int corner{}; corner < 3; ++corner)
+					{
+						if (positions[pCorners[corner]] == from) fromCorner = corner;
+						if (positions[pCorners[corner]] == to) hasTo = true;
+					}
+
+					//Triangles on the collapsed edge disappear
+					if (hasTo) continue;
+
+					const auto isMapped{ [&wedgeMap, pCorners, fromCorner](const std::pair<uint32_t, uint32_t>& mapped) { return mapped.first == pCorners[fromCorner]; } };
+					if (std::none_of(wedgeMap.begin(), wedgeMap.end(), isMapped))
+						return false;
+
+					const Vector3& p0{ vertices[positions[pCorners[0]]].position };
+					const Vector3& p1{ vertices[positions[pCorners[1]]].position };
+					const Vector3& p2{ vertices[positions[pCorners[2]]].position };
+
+					const Vector3 moved0{ fromCorner == 0 ? target : p0 };
+					const Vector3 moved1{ fromCorner == 1 ? target : p1 };
+					const Vector3 moved2{ fromCorner == 2 ? target : p2 };
+
+					const Vector3 normal{ Vector3::Cross(p1 - p0, p2 - p0) };
+					const Vector3 movedNormal{ Vector3::Cross(moved1 - moved0, moved2 - moved0) };
+					if (Vector3::Dot(normal, movedNormal) <= 0.f)
+						return false;
+				}
+
+				return true;
+			}
+
+			void AppendMeshlets(Mesh& mesh, size_t firstIndex, size_t lastIndex, size_t maxVertices, size_t maxTriangles, std::vector<uint32_t>& vertexMeshlets)
+			{
+				Meshlet meshlet{};
+				meshlet.firstIndex = static_cast<uint32_t>(firstIndex);
+				meshlet.firstVertex = static_cast<uint32_t>(mesh.meshletVertices.size());
+
+				for (uint32_t index{ static_cast<uint32_t>(firstIndex) }; index + 2 < lastIndex; index += 3)
+				{
+					size_t nrNewVertices{};
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						nrNewVertices += vertexMeshlets[mesh.indices[index + corner]] != mesh.meshlets.size();
+					}
+
+					//Full, start the next one
+					if (meshlet.nrVertices + nrNewVertices > maxVertices || meshlet.nrIndices / 3 + 1 > maxTriangles)
+					{
+						CalculateBounds(mesh, meshlet);
+						mesh.meshlets.push_back(meshlet);
+
+						meshlet = {};
+						meshlet.firstIndex = index;
+						meshlet.firstVertex = static_cast<uint32_t>(mesh.meshletVertices.size());
+					}
+
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						const uint32_t vertex{ mesh.indices[index + corner] };
+						if (vertexMeshlets[vertex] == mesh.meshlets.size()) continue;
+
+						vertexMeshlets[vertex] = static_cast<uint32_t>(mesh.meshlets.size());
+						mesh.meshletVertices.push_back(vertex);
+						++meshlet.nrVertices;
+					}
+
+					meshlet.nrIndices += 3;
+				}
+
+				if (meshlet.nrIndices > 0)
+				{
+					CalculateBounds(mesh, meshlet);
+					mesh.meshlets.push_back(meshlet);
+				}
+			}
+		}
+
+		float CalculateACMR(const std::vector<uint32_t>& indices, size_t nrVertices, int cacheSize)
+		{
+			if (indices.size() < 3)
+				return 0.f;
+
+			//FIFO: a vertex is in the cache while fewer than cacheSize misses happened since its own miss
+			std::vector<int64_t> missTimes(nrVertices, INT64_MIN / 2);
+			int64_t nrMisses{};
+
+			for (const uint32_t index : indices)
+			{
+				if (nrMisses - missTimes[index] >= cacheSize)
+				{
+					missTimes[index] = nrMisses;
+					++nrMisses;
+				}
+			}
+
+			return static_cast<float>(nrMisses) / (indices.size() / 3);
+		}
+
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t nrVertices, int cacheSize)
+		{
+			const size_t nrTriangles{ indices.size() / 3 };
+			if (nrTriangles == 0)
+				return;
+
+			//Triangles per vertex, as one array with an offset per vertex
+			std::vector<uint32_t> nrLiveTriangles(nrVertices);
+			for (const uint32_t index : indices)
+			{
+				++nrLiveTriangles[index];
+			}
+
+			std::vector<uint32_t> adjacencyOffsets(nrVertices + 1);
+			for (size_t vertex{}; vertex < nrVertices; ++vertex)
+			{
+				adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + nrLiveTriangles[vertex];
+			}
+
+			std::vector<uint32_t> adjacency(indices.size());
+			std::vector<uint32_t> nrAdjacent(nrVertices);
+			for (size_t triangle{}; triangle < nrTriangles; ++triangle)
+			{
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t vertex{ indices[triangle * 3 + corner] };
+					adjacency[adjacencyOffsets[vertex] + nrAdjacent[vertex]++] = static_cast<uint32_t>(triangle);
+				}
+			}
+
+			std::vector<int64_t> cacheTimes(nrVertices, INT64_MIN / 2);
+			std::vector<bool> isEmitted(nrTriangles, false);
+			std::vector<uint32_t> deadEndStack{};
+			std::vector<uint32_t> candidates{};
+
+			std::vector<uint32_t> optimizedIndices{};
+			optimizedIndices.reserve(indices.size());
+
+			int64_t time{ cacheSize + 1 };
+			size_t cursor{};
+			int64_t fanningVertex{ 0 };
+
+			while (fanningVertex >= 0)
+			{
+				candidates.clear();
+
+				//Emit every remaining triangle around the fanning vertex
+				for (uint32_t offset{ adjacencyOffsets[fanningVertex] }; offset < adjacencyOffsets[fanningVertex + 1]; ++offset)
+				{
+					const uint32_t triangle{ adjacency[offset] };
+					if (isEmitted[triangle]) continue;
+
+					for (size_t corner{}; corner < 3; ++corner)
+					{
+						const uint32_t vertex{ indices[triangle * 3 + corner] };
+						optimizedIndices.push_back(vertex);
+						deadEndStack.push_back(vertex);
+						candidates.push_back(vertex);
+
+						--nrLiveTriangles[vertex];
+
+						if (time - cacheTimes[vertex] > cacheSize)
+							cacheTimes[vertex] = time++;
+					}
+
+					isEmitted[triangle] = true;
+				}
+
+				//Next fanning vertex: the candidate that is still in the cache after emitting its triangles and has been there longest
+				fanningVertex = -1;
+				int64_t bestPriority{ -1 };
+				for (const uint32_t candidate : candidates)
+				{
+					if (nrLiveTriangles[candidate] == 0) continue;
+
+					int64_t priority{};
+					if (time - cacheTimes[candidate] + 2 * nrLiveTriangles[candidate] <= cacheSize)
+						priority = time - cacheTimes[candidate];
+
+					if (priority > bestPriority)
+					{
+						bestPriority = priority;
+						fanningVertex = candidate;
+					}
+				}
+
+				if (fanningVertex >= 0) continue;
+
+				//Dead end: go back to a recently used vertex, or else the first one with triangles left
+				while (!deadEndStack.empty() && fanningVertex < 0)
+				{
+					const uint32_t vertex{ deadEndStack.back() };
+					deadEndStack.pop_back();
+
+					if (nrLiveTriangles[vertex] > 0)
+						fanningVertex = vertex;
+				}
+
+				for (; cursor < nrVertices && fanningVertex < 0; ++cursor)
+				{
+					if (nrLiveTriangles[cursor] > 0)
+						fanningVertex = static_cast<int64_t>(cursor);
+				}
+			}
+
+			indices = std::move(optimizedIndices);
+		}
+
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			constexpr uint32_t Unused{ UINT32_MAX };
+			std::vector<uint32_t> remap(vertices.size(), Unused);
+
+			std::vector<Vertex> optimizedVertices{};
+			optimizedVertices.reserve(vertices.size());
+
+			for (uint32_t& index : indices)
+			{
+				if (remap[index] == Unused)
+				{
+					remap[index] = static_cast<uint32_t>(optimizedVertices.size());
+					optimizedVertices.push_back(vertices[index]);
+				}
+
+				index = remap[index];
+			}
+
+			//Vertices no triangle uses are dropped
+			vertices = std::move(optimizedVertices);
+		}
+
+		float Simplify(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, size_t targetIndexCount)
+		{
+			const size_t nrVertices{ vertices.size() };
+
+			//Vertices that only differ in their attributes share one position, the first of them stands for it
+			std::vector<uint32_t> positions(nrVertices);
+			{
+				std::vector<uint32_t> order(nrVertices);
+				std::iota(order.begin(), order.end(), 0);
+
+				const auto isLess{ [&vertices](uint32_t a, uint32_t b)
+					{
+						const Vector3& pa{ vertices[a].position };
+						const Vector3& pb{ vertices[b].position };
+						if (pa.x != pb.x) return pa.x < pb.x;
+						if (pa.y != pb.y) return pa.y < pb.y;
+						if (pa.z != pb.z) return pa.z < pb.z;
+						return a < b;
+					} };
+				std::sort(order.begin(), order.end(), isLess);
+
+				for (size_t sorted{}; sorted < nrVertices; ++sorted)
+				{
+					const bool isSamePosition{ sorted > 0 &&
+						vertices[order[sorted]].position.x == vertices[order[sorted - 1]].position.x &&
+						vertices[order[sorted]].position.y == vertices[order[sorted - 1]].position.y &&
+						vertices[order[sorted]].position.z == vertices[order[sorted - 1]].position.z };
+
+					positions[order[sorted]] = isSamePosition ? positions[order[sorted - 1]] : order[sorted];
+				}
+			}
+
+			const auto getEdgeKey{ [](uint64_t a, uint64_t b) { return std::min(a, b) << 32 | std::max(a, b); } };
+
+			//Triangles per edge between positions, 1 on an open border
+			std::unordered_map<uint64_t, uint32_t> edgeCounts{};
+			const auto countEdges{ [&edgeCounts, &indices, &positions, &getEdgeKey]()
+				{
+					edgeCounts.clear();
+					for (size_t index{}; index + 2 < indices.size(); index += 3)
+					{
+						for (size_t corner{}; corner < 3; ++corner)
+						{
+							++edgeCounts[getEdgeKey(positions[indices[index + corner]], positions[indices[index + (corner + 1) % 3]])];
+						}
+					}
+				} };
+
+			std::vector<Quadric> quadrics(nrVertices);
+			countEdges();
+			for (size_t index{}; index + 2 < indices.size(); index += 3)
+			{
+				const Vector3& p0{ vertices[positions[indices[index]]].position };
+				const Vector3& p1{ vertices[positions[indices[index + 1]]].position };
+				const Vector3& p2{ vertices[positions[indices[index + 2]]].position };
+
+				const Vector3 normal{ Vector3::Cross(p1 - p0, p2 - p0) };
+				const float doubleArea{ normal.Magnitude() };
+				if (doubleArea <= 0.f) continue;
+
+				const Vector3 unitNormal{ normal / doubleArea };
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					AddPlane(quadrics[positions[indices[index + corner]]], unitNormal, -Vector3::Dot(unitNormal, p0), doubleArea * 0.5f);
+				}
+
+				//Border edges also get a plane standing on the triangle, so moving along the border is cheap and moving off it is not
+				for (size_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t a{ positions[indices[index + corner]] };
+					const uint32_t b{ positions[indices[index + (corner + 1) % 3]] };
+					if (edgeCounts[getEdgeKey(a, b)] != 1) continue;
+
+					const Vector3 edge{ vertices[b].position - vertices[a].position };
+					const Vector3 borderNormal{ Vector3::Cross(edge, unitNormal).Normalized() };
+					const float distance{ -Vector3::Dot(borderNormal, vertices[a].position) };
+
+					AddPlane(quadrics[a], borderNormal, distance, edge.SqrMagnitude() * BorderWeight);
+					AddPlane(quadrics[b], borderNormal, distance, edge.SqrMagnitude() * BorderWeight);
+				}
+			}
+
+			std::vector<uint32_t> nrBorderEdges(nrVertices);
+			std::vector<bool> isLocked(nrVertices);
+			std::vector<uint32_t> triangleOffsets(nrVertices + 1);
+			std::vector<uint32_t> triangles{};
+			std::vector<Collapse> collapses{};
+			std::vector<uint32_t> remap(nrVertices);
+			std::vector<bool> isTouched(nrVertices);
+			std::vector<std::pair<uint32_t, uint32_t>> wedgeMap{};
+
+			float maxError{};
+			while (indices.size() > targetIndexCount)
+			{
+				//Border positions only move along the border, positions where it branches or on a non-manifold edge stay where they are
+				countEdges();
+				std::fill(nrBorderEdges.begin(), nrBorderEdges.end(), 0);
+				std::fill(isLocked.begin(), isLocked.end(), false);
+				for (const std::pair<const uint64_t, uint32_t>& edge : edgeCounts)
+				{
+					const uint32_t a{ static_cast<uint32_t>(edge.first >> 32) };
+					const uint32_t b{ static_cast<uint32_t>(edge.first & UINT32_MAX) };
+
+					if (edge.second == 1)
+					{
+						++nrBorderEdges[a];
+						++nrBorderEdges[b];
+					}
+					else if (edge.second > 2)
+					{
+						isLocked[a] = true;
+						isLocked[b] = true;
+					}
+				}
+
+				//Triangles around every position as one array with an offset per position
+				std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+				for (const uint32_t index : indices)
+				{
+					++triangleOffsets[positions[index] + 1];
+				}
+
+				for (size_t position{}; position < nrVertices; ++position)
+				{
+					triangleOffsets[position + 1] += triangleOffsets[position];
+				}
+
+				triangles.resize(indices.size());
+				std::vector<uint32_t> nrAdded(nrVertices);
+				for (uint32_t index{}; index < indices.size(); ++index)
+				{
+					const uint32_t position{ positions[indices[index]] };
+					triangles[triangleOffsets[position] + nrAdded[position]++] = index / 3;
+				}
+
+				//Every edge can collapse either way, cheapest first
+				collapses.clear();
+				for (size_t index{}; index + 2 < indices.size(); index += 3)
+				{
+					for (size_t corner{}; corner < 3; ++corner)
+					{
+						const uint32_t a{ positions[indices[index + corner]] };
+						const uint32_t b{ positions[indices[index + (corner + 1) % 3]] };
+
+						Quadric quadric{ quadrics[a] };
+						AddQuadric(quadric, quadrics[b]);
+
+						//Interior positions can go anywhere, border positions only to a neighbour on the same border
+						const bool isBorderEdge{ edgeCounts[getEdgeKey(a, b)] == 1 };
+						const auto canMove{ [&](uint32_t position) { return !isLocked[position] && (nrBorderEdges[position] == 0 || (nrBorderEdges[position] == 2 && isBorderEdge)); } };
+
+						if (canMove(a)) collapses.push_back({ a, b, GetError(quadric, vertices[b].position) });
+						if (canMove(b)) collapses.push_back({ b, a, GetError(quadric, vertices[a].position) });
+					}
+				}
+
+				//Each edge is listed by both of its triangles
+				const auto isSameEdge{ [](const Collapse& a, const Collapse& b) { return a.from == b.from && a.to == b.to; } };
+				std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.from < b.from || (a.from == b.from && a.to < b.to); });
+				collapses.erase(std::unique(collapses.begin(), collapses.end(), isSameEdge), collapses.end());
+
+				//Checked up front so the limit below only counts collapses that can happen, the checks stay valid for positions no collapse touched
+				const auto isInvalid{ [&](const Collapse& collapse)
+					{
+						const uint32_t* pTriangles{ triangles.data() + triangleOffsets[collapse.from] };
+						const size_t nrTriangles{ triangleOffsets[collapse.from + 1] - triangleOffsets[collapse.from] };
+						return !CanCollapse(vertices, indices, positions, pTriangles, nrTriangles, collapse.from, collapse.to, wedgeMap);
+					} };
+				collapses.erase(std::remove_if(collapses.begin(), collapses.end(), isInvalid), collapses.end());
+
+				std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+				//A collapse removes about two triangles, stop halfway to the target so the next pass sees the updated errors
+				//Collapses skipped because a neighbour went first would otherwise be replaced by ever more expensive ones
+				const size_t maxCollapses{ (indices.size() - targetIndexCount) / 12 + 1 };
+				const float maxPassError{ collapses.empty() ? 0.f : collapses[std::min(maxCollapses, collapses.size()) - 1].error * 1.5f };
+				size_t nrCollapses{};
+
+				std::iota(remap.begin(), remap.end(), 0);
+				std::fill(isTouched.begin(), isTouched.end(), false);
+
+				for (const Collapse& collapse : collapses)
+				{
+					if (nrCollapses >= maxCollapses || (nrCollapses > 0 && collapse.error > maxPassError)) break;
+					if (isTouched[collapse.from] || isTouched[collapse.to]) continue;
+
+					const uint32_t* pTriangles{ triangles.data() + triangleOffsets[collapse.from] };
+					const size_t nrTriangles{ triangleOffsets[collapse.from + 1] - triangleOffsets[collapse.from] };
+					CanCollapse(vertices, indices, positions, pTriangles, nrTriangles, collapse.from, collapse.to, wedgeMap); //Fills the vertex mapping again
+
+					for (const std::pair<uint32_t, uint32_t>& mapped : wedgeMap)
+					{
+						remap[mapped.first] = mapped.second;
+					}
+
+					AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+					maxError = std::max(maxError, collapse.error);
+					++nrCollapses;
+
+					//Collapses in the same pass may not share a triangle, their checks assumed the other one did not happen
+					for (size_t triangle{}; triangle < nrTriangles; ++triangle)
+					{
+						for (size_t corner{}; corner < 3; ++corner)
+						{
+							isTouched[positions[indices[pTriangles[triangle] * 3 + corner]]] = true;
+						}
+					}
+				}
+
+				if (nrCollapses == 0)
+					break;
+
+				//Triangles that lost an edge are dropped
+				size_t nrKept{};
+				for (size_t index{}; index + 2 < indices.size(); index += 3)
+				{
+					const uint32_t i0{ remap[indices[index]] };
+					const uint32_t i1{ remap[indices[index + 1]] };
+					const uint32_t i2{ remap[indices[index + 2]] };
+
+					if (positions[i0] == positions[i1] || positions[i0] == positions[i2] || positions[i1] == positions[i2]) continue;
+
+					indices[nrKept++] = i0;
+					indices[nrKept++] = i1;
+					indices[nrKept++] = i2;
+				}
+
+				indices.resize(nrKept);
+			}
+
+			return std::sqrt(maxError);
+		}
+
+		void BuildLods(Mesh& mesh, size_t maxLods)
+		{
+			mesh.lods.clear();
+			mesh.lods.push_back({ 0, static_cast<uint32_t>(mesh.indices.size()) });
+
+			//Sphere around the center of the bounding box
+			Vector3 minimum{ mesh.vertices.empty() ? Vector3{} : mesh.vertices[0].position };
+			Vector3 maximum{ minimum };
+			for (const Vertex& vertex : mesh.vertices)
+			{
+				for (int axis{}; axis < 3; ++axis)
+				{
+					minimum[axis] = std::min(minimum[axis], vertex.position[axis]);
+					maximum[axis] = std::max(maximum[axis], vertex.position[axis]);
+				}
+			}
+
+			mesh.boundingCenter = (minimum + maximum) * 0.5f;
+			mesh.boundingRadius = 0.f;
+			for (const Vertex& vertex : mesh.vertices)
+			{
+				mesh.boundingRadius = std::max(mesh.boundingRadius, (vertex.position - mesh.boundingCenter).Magnitude());
+			}
+
+			//Every level halves the one before it, the errors add up because each is measured against the level before
+			std::vector<uint32_t> lodIndices{ mesh.indices };
+			float error{};
+			while (mesh.lods.size() < maxLods)
+			{
+				const size_t nrIndices{ lodIndices.size() };
+				error += Simplify(mesh.vertices, lodIndices, nrIndices / 6 * 3);
+
+				//Locked borders and seams stopped the simplification early
+				if (lodIndices.size() > nrIndices * 3 / 4)
+					break;
+
+				OptimizeVertexCache(lodIndices, mesh.vertices.size());
+
+				MeshLod lod{};
+				lod.firstIndex = static_cast<uint32_t>(mesh.indices.size());
+				lod.nrIndices = static_cast<uint32_t>(lodIndices.size());
+				lod.error = error;
+				mesh.lods.push_back(lod);
+
+				mesh.indices.insert(mesh.indices.end(), lodIndices.begin(), lodIndices.end());
+			}
+		}
+
+		void BuildMeshlets(Mesh& mesh, size_t maxVertices, size_t maxTriangles)
+		{
+			mesh.meshlets.clear();
+			mesh.meshletVertices.clear();
+
+			//The meshlet a vertex was last added to, so each meshlet lists it once
+			std::vector<uint32_t> vertexMeshlets(mesh.vertices.size(), UINT32_MAX);
+
+			for (MeshLod& lod : mesh.lods)
+			{
+				lod.firstMeshlet = static_cast<uint32_t>(mesh.meshlets.size());
+				AppendMeshlets(mesh, lod.firstIndex, lod.firstIndex + lod.nrIndices, maxVertices, maxTriangles, vertexMeshlets);
+				lod.nrMeshlets = static_cast<uint32_t>(mesh.meshlets.size()) - lod.firstMeshlet;
+			}
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+//Standard includes
+#include <cstdint>
+#include <vector>
+
+//Project includes
+#include "DataTypes.h"
+
+namespace dae
+{
+	//Load time reordering of triangle lists for the post-transform vertex cache and for vertex fetches
+	namespace MeshOptimizer
+	{
+		constexpr int CacheSize{ 16 };
+
+		constexpr size_t MaxMeshletVertices{ 64 };
+		constexpr size_t MaxMeshletTriangles{ 124 };
+
+		constexpr size_t MaxLods{ 4 };
+
+		//How much more moving a border away from itself costs than moving a surface off its plane
+		constexpr float BorderWeight{ 2.f };
+
+		//Average cache miss ratio: transformed vertices per triangle with a FIFO cache of cacheSize, 0.5 is the best a large mesh can do and 3 the worst
+		float CalculateACMR(const std::vector<uint32_t>& indices, size_t nrVertices, int cacheSize = CacheSize);
+
+		//Reorders the triangles so they reuse recently transformed vertices (Tipsify, Sander et al. 2007)
+		void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t nrVertices, int cacheSize = CacheSize);
+
+		//Reorders the vertices in the order the triangles first use them and remaps the indices
+		void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		//Collapses edges in order of quadric error until at most targetIndexCount indices are left, or no edge can collapse anymore
+		//Vertices are only moved onto each other and not changed, so the simplified triangles keep using the same vertex array
+		//Returns the largest error of a collapse, as a distance
+		float Simplify(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, size_t targetIndexCount);
+
+		//Appends simplified copies of the triangle list to it, each with about half the triangles of the previous level
+		void BuildLods(Mesh& mesh, size_t maxLods = MaxLods);
+
+		//Splits every level of detail into meshlets of consecutive triangles, run it after the reordering so they are compact
+		void BuildMeshlets(Mesh& mesh, size_t maxVertices = MaxMeshletVertices, size_t maxTriangles = MaxMeshletTriangles);
+	}
+}
@@ -0,0 +1,201 @@
+#include "RasterKernel.h"
+
+//External includes
+#if defined(_M_X64) || defined(__SSE2__)
+#define RASTER_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace dae
+{
+	namespace RasterKernel
+	{
+		InstructionSet DetectInstructionSet()
+		{
+#if defined(RASTER_KERNEL_SSE2)
+			bool hasAVX2{ false };
+
+#if defined(_MSC_VER)
+			int cpuInfo[4]{};
+			__cpuid(cpuInfo, 0);
+			if (cpuInfo[0] >= 7)
+			{
+				__cpuid(cpuInfo, 1);
+				const bool hasOSXSAVE{ (cpuInfo[2] & (1 << 27)) != 0 };
+				const bool hasAVX{ (cpuInfo[2] & (1 << 28)) != 0 };
+
+				__cpuidex(cpuInfo, 7, 0);
+				const bool hasAVX2Instructions{ (cpuInfo[1] & (1 << 5)) != 0 };
+
+				//The OS has to save the upper halves of the ymm registers
+				hasAVX2 = hasOSXSAVE && hasAVX && hasAVX2Instructions && (_xgetbv(0) & 0x6) == 0x6;
+			}
+#else
+			__builtin_cpu_init();
+			hasAVX2 = __builtin_cpu_supports("avx2");
+#endif
+
+			if (hasAVX2 && IsAVX2Compiled())
+				return InstructionSet::AVX2;
+
+			return InstructionSet::SSE2;
+#else
+			return InstructionSet::Scalar;
+#endif
+		}
+
+		SpanFunction GetSpanFunction(InstructionSet instructionSet)
+		{
+			switch (instructionSet)
+			{
+			case InstructionSet::AVX2:
+				return &TestSpanAVX2;
+			case InstructionSet::SSE2:
+				return &TestSpanSSE2;
+			default:
+				return &TestSpanScalar;
+			}
+		}
+
+		const char* GetName(InstructionSet instructionSet)
+		{
+			switch (instructionSet)
+			{
+			case InstructionSet::AVX2:
+				return "AVX2";
+			case InstructionSet::SSE2:
+				return "SSE2";
+			default:
+				return "Scalar";
+			}
+		}
+
+		uint32_t TestSpanScalar(const SpanInput& input, int nrPixels, float* pDepth, SpanOutput& output)
+		{
+			uint32_t mask{};
+			output.fillRuleMask = 0;
+
+			for (int lane{}; lane < nrPixels; ++lane)
+			{
+				const float laneOffset{ static_cast<float>(lane) };
+
+				const float weight0{ input.weight[0] + input.stepX[0] * laneOffset };
+				const float weight1{ input.weight[1] + input.stepX[1] * laneOffset };
+				const float weight2{ input.weight[2] + input.stepX[2] * laneOffset };
+
+				//Without the bias, to interpolate with and to find the pixels only the fill rule rejects
+				const float edgeWeight0{ weight0 + input.bias[0] };
+				const float edgeWeight1{ weight1 + input.bias[1] };
+				const float edgeWeight2{ weight2 + input.bias[2] };
+
+				if (!input.isCovered && !(edgeWeight0 >= 0.f && edgeWeight1 >= 0.f && edgeWeight2 >= 0.f)) continue;
+
+				const float ratio0{ edgeWeight0 * input.inverseArea };
+				const float ratio1{ edgeWeight1 * input.inverseArea };
+				const float ratio2{ edgeWeight2 * input.inverseArea };
+
+				const float depth{ ratio0 * input.depth[0] + ratio1 * input.depth[1] + ratio2 * input.depth[2] };
+
+				if (!(depth < pDepth[lane])) continue;
+
+				if (!input.isCovered && !(weight0 >= 0.f && weight1 >= 0.f && weight2 >= 0.f))
+				{
+					output.fillRuleMask |= 1u << lane;
+					continue;
+				}
+
+				pDepth[lane] = depth;
+
+				output.ratio0[lane] = ratio0;
+				output.ratio1[lane] = ratio1;
+				output.ratio2[lane] = ratio2;
+				output.depth[lane] = depth;
+
+				mask |= 1u << lane;
+			}
+
+			return mask;
+		}
+
+		uint32_t TestSpanSSE2(const SpanInput& input, int nrPixels, float* pDepth, SpanOutput& output)
+		{
+#if defined(RASTER_KERNEL_SSE2)
+			const __m128 zero{ _mm_setzero_ps() };
+			const __m128 inverseArea{ _mm_set1_ps(input.inverseArea) };
+
+			uint32_t mask{};
+			output.fillRuleMask = 0;
+
+			//Two halves of 4 pixels
+			for (int half{}; half < 2; ++half)
+			{
+				const int firstLane{ half * 4 };
+				if (firstLane >= nrPixels) break;
+
+				const __m128 laneOffsets{ _mm_setr_ps(firstLane + 0.f, firstLane + 1.f, firstLane + 2.f, firstLane + 3.f) };
+
+				const __m128 weight0{ _mm_add_ps(_mm_set1_ps(input.weight[0]), _mm_mul_ps(_mm_set1_ps(input.stepX[0]), laneOffsets)) };
+				const __m128 weight1{ _mm_add_ps(_mm_set1_ps(input.weight[1]), _mm_mul_ps(_mm_set1_ps(input.stepX[1]), laneOffsets)) };
+				const __m128 weight2{ _mm_add_ps(_mm_set1_ps(input.weight[2]), _mm_mul_ps(_mm_set1_ps(input.stepX[2]), laneOffsets)) };
+
+				const __m128 edgeWeight0{ _mm_add_ps(weight0, _mm_set1_ps(input.bias[0])) };
+				const __m128 edgeWeight1{ _mm_add_ps(weight1, _mm_set1_ps(input.bias[1])) };
+				const __m128 edgeWeight2{ _mm_add_ps(weight2, _mm_set1_ps(input.bias[2])) };
+
+				__m128 isCovered{ _mm_cmpeq_ps(zero, zero) };
+				__m128 isCoveredWithoutBias{ isCovered };
+				if (!input.isCovered)
+				{
+					isCovered = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(weight0, zero), _mm_cmpge_ps(weight1, zero)), _mm_cmpge_ps(weight2, zero));
+					isCoveredWithoutBias = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edgeWeight0, zero), _mm_cmpge_ps(edgeWeight1, zero)), _mm_cmpge_ps(edgeWeight2, zero));
+				}
+
+				//No masked loads in SSE2, copy the valid part of the depth row
+				const int nrLanes{ nrPixels - firstLane < 4 ? nrPixels - firstLane : 4 };
+				alignas(16) float storedDepth[4]{};
+				for (int lane{}; lane < nrLanes; ++lane)
+				{
+					storedDepth[lane] = pDepth[firstLane + lane];
+				}
+
+				const __m128 ratio0{ _mm_mul_ps(edgeWeight0, inverseArea) };
+				const __m128 ratio1{ _mm_mul_ps(edgeWeight1, inverseArea) };
+				const __m128 ratio2{ _mm_mul_ps(edgeWeight2, inverseArea) };
+
+				const __m128 depth{ _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(ratio0, _mm_set1_ps(input.depth[0])),
+					_mm_mul_ps(ratio1, _mm_set1_ps(input.depth[1]))),
+					_mm_mul_ps(ratio2, _mm_set1_ps(input.depth[2]))) };
+
+				const __m128 isCloser{ _mm_cmplt_ps(depth, _mm_load_ps(storedDepth)) };
+				const uint32_t validMask{ (1u << nrLanes) - 1 };
+
+				const uint32_t halfMask{ static_cast<uint32_t>(_mm_movemask_ps(_mm_and_ps(isCovered, isCloser))) & validMask };
+				const uint32_t fillRuleMask{ static_cast<uint32_t>(_mm_movemask_ps(_mm_and_ps(_mm_andnot_ps(isCovered, isCoveredWithoutBias), isCloser))) & validMask };
+
+				_mm_store_ps(output.ratio0 + firstLane, ratio0);
+				_mm_store_ps(output.ratio1 + firstLane, ratio1);
+				_mm_store_ps(output.ratio2 + firstLane, ratio2);
+				_mm_store_ps(output.depth + firstLane, depth);
+
+				for (int lane{}; lane < nrLanes; ++lane)
+				{
+					if (halfMask & (1u << lane))
+						pDepth[firstLane + lane] = output.depth[firstLane + lane];
+				}
+
+				mask |= halfMask << firstLane;
+				output.fillRuleMask |= fillRuleMask << firstLane;
+			}
+
+			return mask;
+#else
+			return TestSpanScalar(input, nrPixels, pDepth, output);
+#endif
+		}
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+//Standard includes
+#include <cstdint>
+
+namespace dae
+{
+	//Coverage and depth test for a span of up to 8 pixels on one row of a triangle
+	//Every kernel does the same float operations in the same order, so they all produce the same image
+	namespace RasterKernel
+	{
+		constexpr int SpanWidth{ 8 };
+
+		struct SpanInput
+		{
+			//Edge weights at the first pixel of the span and their step per pixel
+			//The weights already have the fill rule bias subtracted, a lane is covered when all three are >= 0
+			float weight[3]{};
+			float stepX[3]{};
+			float bias[3]{};
+			float inverseArea{};
+
+			//Set when the whole span is known to be inside the triangle, the kernels then skip the coverage test
+			bool isCovered{ false };
+
+			//NDC z of the three vertices, it is linear in screen space
+			float depth[3]{};
+		};
+
+		struct SpanOutput
+		{
+			//Barycentric ratios and depth per lane, only valid for the lanes in the returned mask
+			alignas(32) float ratio0[SpanWidth];
+			alignas(32) float ratio1[SpanWidth];
+			alignas(32) float ratio2[SpanWidth];
+			alignas(32) float depth[SpanWidth];
+
+			//Lanes that only the fill rule bias kept out while they would have passed the depth test
+			uint32_t fillRuleMask;
+		};
+
+		//Tests nrPixels (1 to SpanWidth) pixels starting at pDepth, writes the depth of every covered pixel that passes the depth test
+		//and returns those pixels as a bitmask, bit i being pDepth[i]. Pixels past nrPixels are neither read nor written.
+		using SpanFunction = uint32_t(*)(const SpanInput& input, int nrPixels, float* pDepth, SpanOutput& output);
+
+		enum class InstructionSet { Scalar, SSE2, AVX2 };
+
+		//Best instruction set this CPU and build support
+		InstructionSet DetectInstructionSet();
+		SpanFunction GetSpanFunction(InstructionSet instructionSet);
+		const char* GetName(InstructionSet instructionSet);
+
+		uint32_t TestSpanScalar(const SpanInput& input, int nrPixels, float* pDepth, SpanOutput& output);
+		uint32_t TestSpanSSE2(const SpanInput& input, int nrPixels, float* pDepth, SpanOutput& output);
+
+		//Compiled separately with AVX2 enabled, only call it when DetectInstructionSet reports AVX2
+		uint32_t TestSpanAVX2(const SpanInput& input, int nrPixels, float* pDepth, SpanOutput& output);
+		bool IsAVX2Compiled();
+	}
+}
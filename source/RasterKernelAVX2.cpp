@@ -0,0 +1,91 @@
+//This file is compiled with AVX2 enabled (/arch:AVX2, -mavx2), see RasterKernel::DetectInstructionSet
+#include "RasterKernel.h"
+
+//External includes
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace dae
+{
+	namespace RasterKernel
+	{
+		bool IsAVX2Compiled()
+		{
+#if defined(__AVX2__)
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		uint32_t TestSpanAVX2(const SpanInput& input, int nrPixels, float* pDepth, SpanOutput& output)
+		{
+#if defined(__AVX2__)
+			const __m256 zero{ _mm256_setzero_ps() };
+			const __m256 inverseArea{ _mm256_set1_ps(input.inverseArea) };
+
+			const __m256i laneIndices{ _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7) };
+			const __m256 laneOffsets{ _mm256_cvtepi32_ps(laneIndices) };
+
+			//Lanes past nrPixels are never loaded or stored
+			const __m256i isValid{ _mm256_cmpgt_epi32(_mm256_set1_epi32(nrPixels), laneIndices) };
+
+			const __m256 weight0{ _mm256_add_ps(_mm256_set1_ps(input.weight[0]), _mm256_mul_ps(_mm256_set1_ps(input.stepX[0]), laneOffsets)) };
+			const __m256 weight1{ _mm256_add_ps(_mm256_set1_ps(input.weight[1]), _mm256_mul_ps(_mm256_set1_ps(input.stepX[1]), laneOffsets)) };
+			const __m256 weight2{ _mm256_add_ps(_mm256_set1_ps(input.weight[2]), _mm256_mul_ps(_mm256_set1_ps(input.stepX[2]), laneOffsets)) };
+
+			const __m256 edgeWeight0{ _mm256_add_ps(weight0, _mm256_set1_ps(input.bias[0])) };
+			const __m256 edgeWeight1{ _mm256_add_ps(weight1, _mm256_set1_ps(input.bias[1])) };
+			const __m256 edgeWeight2{ _mm256_add_ps(weight2, _mm256_set1_ps(input.bias[2])) };
+
+			__m256 isCovered{ _mm256_castsi256_ps(isValid) };
+			__m256 isCoveredWithoutBias{ isCovered };
+
+			output.fillRuleMask = 0;
+			if (!input.isCovered)
+			{
+				isCovered = _mm256_and_ps(_mm256_and_ps(
+					_mm256_cmp_ps(weight0, zero, _CMP_GE_OQ),
+					_mm256_cmp_ps(weight1, zero, _CMP_GE_OQ)),
+					_mm256_cmp_ps(weight2, zero, _CMP_GE_OQ));
+
+				isCoveredWithoutBias = _mm256_and_ps(_mm256_and_ps(_mm256_and_ps(
+					_mm256_cmp_ps(edgeWeight0, zero, _CMP_GE_OQ),
+					_mm256_cmp_ps(edgeWeight1, zero, _CMP_GE_OQ)),
+					_mm256_cmp_ps(edgeWeight2, zero, _CMP_GE_OQ)),
+					_mm256_castsi256_ps(isValid));
+
+				if (_mm256_testz_ps(isCoveredWithoutBias, isCoveredWithoutBias))
+					return 0;
+			}
+
+			const __m256 ratio0{ _mm256_mul_ps(edgeWeight0, inverseArea) };
+			const __m256 ratio1{ _mm256_mul_ps(edgeWeight1, inverseArea) };
+			const __m256 ratio2{ _mm256_mul_ps(edgeWeight2, inverseArea) };
+
+			const __m256 depth{ _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(ratio0, _mm256_set1_ps(input.depth[0])),
+				_mm256_mul_ps(ratio1, _mm256_set1_ps(input.depth[1]))),
+				_mm256_mul_ps(ratio2, _mm256_set1_ps(input.depth[2]))) };
+
+			const __m256 storedDepth{ _mm256_maskload_ps(pDepth, isValid) };
+			const __m256 isCloser{ _mm256_and_ps(isCoveredWithoutBias, _mm256_cmp_ps(depth, storedDepth, _CMP_LT_OQ)) };
+			const __m256 isPassing{ _mm256_and_ps(isCovered, isCloser) };
+
+			output.fillRuleMask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_andnot_ps(isCovered, isCloser)));
+
+			_mm256_maskstore_ps(pDepth, _mm256_castps_si256(isPassing), depth);
+
+			_mm256_store_ps(output.ratio0, ratio0);
+			_mm256_store_ps(output.ratio1, ratio1);
+			_mm256_store_ps(output.ratio2, ratio2);
+			_mm256_store_ps(output.depth, depth);
+
+			return static_cast<uint32_t>(_mm256_movemask_ps(isPassing));
+#else
+			return TestSpanSSE2(input, nrPixels, pDepth, output);
+#endif
+		}
+	}
+}
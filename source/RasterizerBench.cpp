@@ -0,0 +1,557 @@
+//External includes
+#include "SDL.h"
+#undef main
+
+//Standard includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//Project includes
+#include "Renderer.h"
+#include "RenderTarget.h"
+#include "Texture.h"
+#include "Timer.h"
+
+using namespace dae;
+
+namespace
+{
+	struct Resolution
+	{
+		int width{};
+		int height{};
+	};
+
+	struct BenchSettings
+	{
+		int nrFrames{ 100 };
+		int nrWarmupFrames{ 5 };
+		int nrThreads{ 0 };
+		bool hasInstructionSet{ false };
+		RasterKernel::InstructionSet instructionSet{};
+		std::vector<Resolution> resolutions{ { 640, 480 }, { 1920, 1080 } };
+		std::vector<std::string> meshes{ "Resources/vehicle.obj", "Resources/tuktuk.obj" };
+		std::vector<bool> shadingModes{ false, true }; //Use the visibility buffer
+		bool measureFragmentShading{ false }; //Time forward shading per fragment, the clock reads inflate the other stages
+		Renderer::CullMode cullMode{ Renderer::CullMode::Back };
+		bool isStatic{ false }; //Keep the mesh still, so frames after the first are reused
+		float meshDistance{ 50.f };
+		bool useLods{ true };
+		Renderer::MaterialMode materialMode{ Renderer::MaterialMode::Packed };
+		bool useMipmaps{ true };
+
+		//Only time texture sampling along rotated lines, once per texel layout
+		bool isSamplingBenchmark{ false };
+		std::string samplingTexture{ "Resources/vehicle_diffuse.png" };
+
+		std::string outputPath{};
+	};
+
+	std::vector<std::string> Split(const std::string& text, char delimiter)
+	{
+		std::vector<std::string> parts{};
+		std::stringstream stream{ text };
+
+		std::string part{};
+		while (std::getline(stream, part, delimiter))
+		{
+			if (!part.empty())
+				parts.push_back(part);
+		}
+
+		return parts;
+	}
+
+	bool ParseArguments(int argc, char* args[], BenchSettings& settings)
+	{
+		for (int index{ 1 }; index < argc; ++index)
+		{
+			const std::string argument{ args[index] };
+			const bool hasValue{ index + 1 < argc };
+
+			if (argument == "--frames" && hasValue)
+			{
+				settings.nrFrames = std::max(1, std::atoi(args[++index]));
+			}
+			else if (argument == "--warmup" && hasValue)
+			{
+				settings.nrWarmupFrames = std::max(0, std::atoi(args[++index]));
+			}
+			else if (argument == "--threads" && hasValue)
+			{
+				settings.nrThreads = std::max(0, std::atoi(args[++index]));
+			}
+			else if (argument == "--isa" && hasValue)
+			{
+				const std::string name{ args[++index] };
+				if (name == "scalar")
+					settings.instructionSet = RasterKernel::InstructionSet::Scalar;
+				else if (name == "sse2")
+					settings.instructionSet = RasterKernel::InstructionSet::SSE2;
+				else if (name == "avx2")
+					settings.instructionSet = RasterKernel::InstructionSet::AVX2;
+				else
+					return false;
+
+				settings.hasInstructionSet = true;
+			}
+			else if (argument == "--resolutions" && hasValue)
+			{
+				//e.g. 640x480,1920x1080
+				settings.resolutions.clear();
+				for (const std::string& resolution : Split(args[++index], ','))
+				{
+					const std::vector<std::string> size{ Split(resolution, 'x') };
+					if (size.size() != 2)
+						return false;
+
+					settings.resolutions.push_back({ std::atoi(size[0].c_str()), std::atoi(size[1].c_str()) });
+					if (settings.resolutions.back().width <= 0 || settings.resolutions.back().height <= 0)
+						return false;
+				}
+			}
+			else if (argument == "--meshes" && hasValue)
+			{
+				settings.meshes = Split(args[++index], ',');
+			}
+			else if (argument == "--fragment-timing")
+			{
+				settings.measureFragmentShading = true;
+			}
+			else if (argument == "--shading" && hasValue)
+			{
+				//e.g. forward,visibility
+				settings.shadingModes.clear();
+				for (const std::string& mode : Split(args[++index], ','))
+				{
+					if (mode != "forward" && mode != "visibility")
+						return false;
+
+					settings.shadingModes.push_back(mode == "visibility");
+				}
+			}
+			else if (argument == "--cull" && hasValue)
+			{
+				const std::string name{ args[++index] };
+				if (name == "none")
+					settings.cullMode = Renderer::CullMode::None;
+				else if (name == "back")
+					settings.cullMode = Renderer::CullMode::Back;
+				else if (name == "front")
+					settings.cullMode = Renderer::CullMode::Front;
+				else
+					return false;
+			}
+			else if (argument == "--static")
+			{
+				settings.isStatic = true;
+			}
+			else if (argument == "--distance" && hasValue)
+			{
+				settings.meshDistance = static_cast<float>(std::atof(args[++index]));
+				if (settings.meshDistance <= 0.f)
+					return false;
+			}
+			else if (argument == "--lods" && hasValue)
+			{
+				const std::string value{ args[++index] };
+				if (value != "on" && value != "off")
+					return false;
+
+				settings.useLods = value == "on";
+			}
+			else if (argument == "--material" && hasValue)
+			{
+				const std::string name{ args[++index] };
+				if (name == "separate")
+					settings.materialMode = Renderer::MaterialMode::Separate;
+				else if (name == "packed")
+					settings.materialMode = Renderer::MaterialMode::Packed;
+				else if (name == "compressed")
+					settings.materialMode = Renderer::MaterialMode::Compressed;
+				else
+					return false;
+			}
+			else if (argument == "--mipmaps" && hasValue)
+			{
+				const std::string value{ args[++index] };
+				if (value != "on" && value != "off")
+					return false;
+
+				settings.useMipmaps = value == "on";
+			}
+			else if (argument == "--sampling")
+			{
+				settings.isSamplingBenchmark = true;
+			}
+			else if (argument == "--texture" && hasValue)
+			{
+				settings.samplingTexture = args[++index];
+			}
+			else if (argument == "--output" && hasValue)
+			{
+				settings.outputPath = args[++index];
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return !settings.resolutions.empty() && !settings.meshes.empty() && !settings.shadingModes.empty();
+	}
+
+	//Writes min/median/p99 of the given samples as a JSON object, unit is appended to the keys
+	void WriteSummary(std::ostream& output, std::vector<float> samples, const std::string& unit = "_ms")
+	{
+		std::sort(samples.begin(), samples.end());
+
+		const auto percentile = [&samples](float fraction)
+		{
+			const size_t index{ static_cast<size_t>(fraction * (samples.size() - 1) + 0.5f) };
+			return samples[index];
+		};
+
+		output << "{ \"min" << unit << "\": " << samples.front()
+			<< ", \"median" << unit << "\": " << percentile(0.5f)
+			<< ", \"p99" << unit << "\": " << percentile(0.99f) << " }";
+	}
+
+	struct StageSamples
+	{
+		std::vector<float> clear{};
+		std::vector<float> vertexTransformation{};
+		std::vector<float> rasterization{};
+		std::vector<float> pixelShading{};
+		std::vector<float> present{};
+		std::vector<float> total{};
+
+		std::vector<float> fillRuleSkips{};
+		std::vector<float> rejectedBlocks{};
+		std::vector<float> acceptedBlocks{};
+		std::vector<float> coverageTests{};
+		std::vector<float> occludedTiles{};
+		std::vector<float> occludedBlocks{};
+		std::vector<float> shadedFragments{};
+		std::vector<float> culledTriangles{};
+		std::vector<float> clippedTriangles{};
+		std::vector<float> transformedVertices{};
+		std::vector<float> culledMeshlets{};
+		std::vector<float> lodTriangles{};
+		std::vector<float> reusedFrames{};
+	};
+
+	//<name>.obj is shaded with the <name>_diffuse, _normal, _gloss and _specular maps next to it that exist,
+	//or with <name>.png as its only map when it has no diffuse map
+	Renderer::MaterialPaths GetMaterialPaths(const std::string& meshPath)
+	{
+		std::filesystem::path stem{ meshPath };
+		stem.replace_extension();
+
+		const auto getPath{ [&stem](const std::string& suffix)
+			{
+				const std::string path{ stem.string() + suffix + ".png" };
+				return std::filesystem::exists(path) ? path : std::string{};
+			} };
+
+		Renderer::MaterialPaths paths{ getPath("_diffuse"), getPath("_normal"), getPath("_gloss"), getPath("_specular") };
+		if (paths.diffuse.empty())
+			paths.diffuse = stem.string() + ".png";
+
+		return paths;
+	}
+
+	const char* GetCullModeName(Renderer::CullMode cullMode)
+	{
+		switch (cullMode)
+		{
+		case Renderer::CullMode::None:
+			return "none";
+		case Renderer::CullMode::Front:
+			return "front";
+		default:
+			return "back";
+		}
+	}
+
+	const char* GetMaterialModeName(Renderer::MaterialMode materialMode)
+	{
+		switch (materialMode)
+		{
+		case Renderer::MaterialMode::Separate:
+			return "separate";
+		case Renderer::MaterialMode::Compressed:
+			return "compressed";
+		default:
+			return "packed";
+		}
+	}
+
+	void WriteRun(std::ostream& output, const std::string& mesh, const Resolution& resolution, float distance, bool isFragmentTimed, const Renderer& renderer, const StageSamples& samples)
+	{
+		output << "    {\n";
+		output << "      \"mesh\": \"" << mesh << "\",\n";
+		output << "      \"width\": " << resolution.width << ",\n";
+		output << "      \"height\": " << resolution.height << ",\n";
+		output << "      \"vertices\": " << renderer.GetMeshStatistics().nrVertices << ",\n";
+		output << "      \"indices\": " << renderer.GetMeshStatistics().nrIndices << ",\n";
+		output << "      \"meshlets\": " << renderer.GetMeshStatistics().nrMeshlets << ",\n";
+		output << "      \"acmr\": { \"loaded\": " << renderer.GetMeshStatistics().loadedACMR << ", \"optimized\": " << renderer.GetMeshStatistics().optimizedACMR << " },\n";
+
+		output << "      \"lod_levels\": [";
+		for (size_t lod{}; lod < renderer.GetMeshStatistics().nrLodTriangles.size(); ++lod)
+		{
+			output << (lod > 0 ? ", " : " ") << "{ \"triangles\": " << renderer.GetMeshStatistics().nrLodTriangles[lod] << ", \"error\": " << renderer.GetMeshStatistics().lodErrors[lod] << " }";
+		}
+		output << " ],\n";
+		output << "      \"threads\": " << renderer.GetThreadCount() << ",\n";
+		output << "      \"instruction_set\": \"" << RasterKernel::GetName(renderer.GetInstructionSet()) << "\",\n";
+		output << "      \"shading\": \"" << (renderer.GetUseVisibilityBuffer() ? "visibility" : "forward") << "\",\n";
+		output << "      \"pixel_shading_timing\": \"" << (renderer.GetUseVisibilityBuffer() ? "per_tile" : (isFragmentTimed ? "per_fragment" : "in_rasterization")) << "\",\n";
+		output << "      \"cull\": \"" << GetCullModeName(renderer.GetCullMode()) << "\",\n";
+		output << "      \"distance\": " << distance << ",\n";
+		output << "      \"lods\": " << (renderer.GetUseLods() ? "true" : "false") << ",\n";
+		output << "      \"material\": \"" << GetMaterialModeName(renderer.GetMaterialMode()) << "\",\n";
+		output << "      \"material_bytes\": " << renderer.GetMaterialMemorySize(renderer.GetMaterialMode()) << ",\n";
+		output << "      \"mipmaps\": " << (renderer.GetUseMipmaps() ? "true" : "false") << ",\n";
+		output << "      \"stages\": {\n";
+		output << "        \"clear\": "; WriteSummary(output, samples.clear); output << ",\n";
+		output << "        \"vertex_transformation\": "; WriteSummary(output, samples.vertexTransformation); output << ",\n";
+		output << "        \"rasterization\": "; WriteSummary(output, samples.rasterization); output << ",\n";
+		output << "        \"pixel_shading\": "; WriteSummary(output, samples.pixelShading); output << ",\n";
+		output << "        \"present\": "; WriteSummary(output, samples.present); output << "\n";
+		output << "      },\n";
+		output << "      \"frame\": "; WriteSummary(output, samples.total); output << ",\n";
+		output << "      \"counters\": {\n";
+		output << "        \"fill_rule_skipped_pixels\": "; WriteSummary(output, samples.fillRuleSkips, ""); output << ",\n";
+		output << "        \"rejected_blocks\": "; WriteSummary(output, samples.rejectedBlocks, ""); output << ",\n";
+		output << "        \"accepted_blocks\": "; WriteSummary(output, samples.acceptedBlocks, ""); output << ",\n";
+		output << "        \"coverage_tested_pixels\": "; WriteSummary(output, samples.coverageTests, ""); output << ",\n";
+		output << "        \"occluded_tiles\": "; WriteSummary(output, samples.occludedTiles, ""); output << ",\n";
+		output << "        \"occluded_blocks\": "; WriteSummary(output, samples.occludedBlocks, ""); output << ",\n";
+		output << "        \"shaded_fragments\": "; WriteSummary(output, samples.shadedFragments, ""); output << ",\n";
+		output << "        \"culled_triangles\": "; WriteSummary(output, samples.culledTriangles, ""); output << ",\n";
+		output << "        \"clipped_triangles\": "; WriteSummary(output, samples.clippedTriangles, ""); output << ",\n";
+		output << "        \"transformed_vertices\": "; WriteSummary(output, samples.transformedVertices, ""); output << ",\n";
+		output << "        \"culled_meshlets\": "; WriteSummary(output, samples.culledMeshlets, ""); output << ",\n";
+		output << "        \"lod_triangles\": "; WriteSummary(output, samples.lodTriangles, ""); output << ",\n";
+		output << "        \"reused_frames\": "; WriteSummary(output, samples.reusedFrames, ""); output << "\n";
+		output << "      }\n";
+		output << "    }";
+	}
+
+	//Prints to the console without an output path
+	bool WriteOutput(const std::string& outputPath, const std::string& json)
+	{
+		if (outputPath.empty())
+		{
+			std::cout << json;
+			return true;
+		}
+
+		std::ofstream file{ outputPath };
+		if (!file)
+		{
+			std::cerr << "Could not write " << outputPath << std::endl;
+			return false;
+		}
+		file << json;
+		return true;
+	}
+
+	//Samples a SamplingSize x SamplingSize grid of pixels whose UVs are rotated by the given angle, like a triangle running at that angle in UV space
+	//The grid covers 70% of the texture's width, so every angle stays inside it and reads level 0
+	float MeasureSampling(const Texture& texture, float angle, float& sink)
+	{
+		constexpr int SamplingSize{ 1024 };
+		constexpr float Coverage{ 0.7f };
+
+		const MipLevel& level{ texture.GetLevel(0) };
+		const float cosAngle{ std::cos(angle * TO_RADIANS) };
+		const float sinAngle{ std::sin(angle * TO_RADIANS) };
+		const Vector2 uvDerivativeX{ Coverage / SamplingSize * cosAngle, Coverage / SamplingSize * sinAngle * level.width / level.height };
+		const Vector2 uvDerivativeY{ -Coverage / SamplingSize * sinAngle, Coverage / SamplingSize * cosAngle * level.width / level.height };
+
+		const auto start{ std::chrono::steady_clock::now() };
+
+		float sum{};
+		for (int py{}; py < SamplingSize; ++py)
+		{
+			const float offsetY{ py - SamplingSize * 0.5f };
+			for (int px{}; px < SamplingSize; ++px)
+			{
+				const float offsetX{ px - SamplingSize * 0.5f };
+				const Vector2 uv{ 0.5f + uvDerivativeX.x * offsetX + uvDerivativeY.x * offsetY, 0.5f + uvDerivativeX.y * offsetX + uvDerivativeY.y * offsetY };
+				sum += texture.Sample(uv, uvDerivativeX, uvDerivativeY).m_pGreen;
+			}
+		}
+
+		sink += sum;
+		return std::chrono::duration<float, std::nano>(std::chrono::steady_clock::now() - start).count() / (SamplingSize * SamplingSize);
+	}
+
+	bool RunSamplingBenchmark(std::ostream& output, const BenchSettings& settings)
+	{
+		output << "  \"sampling\": [\n";
+
+		float sink{};
+		bool isFirstRun{ true };
+		for (const TextureLayout layout : { TextureLayout::Linear, TextureLayout::Morton })
+		{
+			const Texture* pTexture{ Texture::LoadFromFile(settings.samplingTexture, layout) };
+			if (!pTexture)
+				return false;
+
+			for (const float angle : { 0.f, 30.f, 45.f, 90.f })
+			{
+				std::vector<float> samples{};
+				for (int pass{ -settings.nrWarmupFrames }; pass < settings.nrFrames; ++pass)
+				{
+					const float nanoseconds{ MeasureSampling(*pTexture, angle, sink) };
+					if (pass >= 0)
+						samples.push_back(nanoseconds);
+				}
+
+				if (!isFirstRun)
+					output << ",\n";
+				isFirstRun = false;
+
+				output << "    { \"texture\": \"" << settings.samplingTexture << "\", \"layout\": \"" << (layout == TextureLayout::Morton ? "morton" : "linear")
+					<< "\", \"angle\": " << angle << ", \"per_sample\": ";
+				WriteSummary(output, samples, "_ns");
+				output << " }";
+			}
+
+			delete pTexture;
+		}
+
+		//Keeps the samples from being optimized away
+		output << "\n  ],\n  \"checksum\": " << sink << "\n";
+		return true;
+	}
+}
+
+int main(int argc, char* args[])
+{
+	BenchSettings settings{};
+	if (!ParseArguments(argc, args, settings))
+	{
+		std::cerr << "Usage: rasterizer_bench [--frames N] [--warmup N] [--threads N] [--isa scalar|sse2|avx2] [--resolutions WxH,...] [--meshes a.obj,...] [--shading forward,visibility] [--fragment-timing] [--cull none|back|front] [--static] [--distance D] [--lods on|off] [--material separate|packed|compressed] [--mipmaps on|off] [--sampling] [--texture file.png] [--output file.json]" << std::endl;
+		return 1;
+	}
+
+	//No SDL_Init: rendering happens headless into a MemoryRenderTarget
+	std::ostringstream json{};
+	json << "{\n  \"frames\": " << settings.nrFrames << ",\n";
+
+	if (settings.isSamplingBenchmark)
+	{
+		if (!RunSamplingBenchmark(json, settings))
+		{
+			std::cerr << "Could not load " << settings.samplingTexture << std::endl;
+			return 1;
+		}
+		json << "}\n";
+
+		return WriteOutput(settings.outputPath, json.str()) ? 0 : 1;
+	}
+
+	json << "  \"runs\": [\n";
+
+	bool isFirstRun{ true };
+	for (const std::string& meshPath : settings.meshes)
+	{
+		for (const Resolution& resolution : settings.resolutions)
+		{
+			for (const bool useVisibilityBuffer : settings.shadingModes)
+			{
+				Timer timer{};
+				MemoryRenderTarget renderTarget{ resolution.width, resolution.height };
+				Renderer renderer{ &renderTarget };
+
+				if (!renderer.LoadMesh(meshPath))
+				{
+					std::cerr << "Could not load " << meshPath << std::endl;
+					return 1;
+				}
+
+				std::string failedPath{};
+				if (!renderer.LoadMaterial(GetMaterialPaths(meshPath), failedPath))
+				{
+					std::cerr << "Could not load " << failedPath << std::endl;
+					return 1;
+				}
+
+				//First update sets up the camera, after that the rotation is driven per frame so every run renders the same views
+				timer.Start();
+				timer.Update();
+				renderer.Update(&timer);
+				renderer.ToggleRotation();
+				renderer.SetMeasurePixelShading(settings.measureFragmentShading);
+				renderer.SetThreadCount(settings.nrThreads);
+				renderer.SetUseVisibilityBuffer(useVisibilityBuffer);
+				renderer.SetCullMode(settings.cullMode);
+				renderer.SetMeshDistance(settings.meshDistance);
+				renderer.SetUseLods(settings.useLods);
+				renderer.SetMaterialMode(settings.materialMode);
+				renderer.SetUseMipmaps(settings.useMipmaps);
+
+				//Asking for more than the CPU supports falls back to the detected instruction set
+				if (settings.hasInstructionSet && settings.instructionSet <= RasterKernel::DetectInstructionSet())
+					renderer.SetInstructionSet(settings.instructionSet);
+
+				StageSamples samples{};
+				for (int frame{ -settings.nrWarmupFrames }; frame < settings.nrFrames; ++frame)
+				{
+					if (!settings.isStatic || frame == -settings.nrWarmupFrames)
+						renderer.SetRotationAngle(frame * 0.05f);
+
+					renderer.Render();
+
+					if (frame < 0)
+						continue;
+
+					const RenderStatistics& statistics{ renderer.GetStatistics() };
+					samples.clear.push_back(statistics.clearTime);
+					samples.vertexTransformation.push_back(statistics.vertexTransformationTime);
+					samples.rasterization.push_back(statistics.rasterizationTime);
+					samples.pixelShading.push_back(statistics.pixelShadingTime);
+					samples.present.push_back(statistics.presentTime);
+					samples.total.push_back(statistics.clearTime + statistics.vertexTransformationTime + statistics.rasterizationTime + statistics.pixelShadingTime + statistics.presentTime);
+
+					samples.fillRuleSkips.push_back(static_cast<float>(statistics.nrFillRuleSkips));
+					samples.rejectedBlocks.push_back(static_cast<float>(statistics.nrRejectedBlocks));
+					samples.acceptedBlocks.push_back(static_cast<float>(statistics.nrAcceptedBlocks));
+					samples.coverageTests.push_back(static_cast<float>(statistics.nrCoverageTests));
+					samples.occludedTiles.push_back(static_cast<float>(statistics.nrOccludedTiles));
+					samples.occludedBlocks.push_back(static_cast<float>(statistics.nrOccludedBlocks));
+					samples.shadedFragments.push_back(static_cast<float>(statistics.nrShadedFragments));
+					samples.culledTriangles.push_back(static_cast<float>(statistics.nrCulledTriangles));
+					samples.clippedTriangles.push_back(static_cast<float>(statistics.nrClippedTriangles));
+					samples.transformedVertices.push_back(static_cast<float>(statistics.nrTransformedVertices));
+					samples.culledMeshlets.push_back(static_cast<float>(statistics.nrCulledMeshlets));
+					samples.lodTriangles.push_back(static_cast<float>(statistics.nrLodTriangles));
+					samples.reusedFrames.push_back(statistics.isFrameReused ? 1.f : 0.f);
+				}
+
+				if (!isFirstRun)
+					json << ",\n";
+				isFirstRun = false;
+
+				WriteRun(json, meshPath, resolution, settings.meshDistance, settings.measureFragmentShading, renderer, samples);
+			}
+		}
+	}
+
+	json << "\n  ]\n}\n";
+
+	return WriteOutput(settings.outputPath, json.str()) ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+//External includes
+#include "SDL.h"
+#include "SDL_surface.h"
+
+//Project includes
+#include "RenderTarget.h"
+
+using namespace dae;
+
+RenderTarget::RenderTarget(int width, int height) :
+	m_Width{ width },
+	m_Height{ height }
+{
+	//Create Buffers
+	m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
+	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+
+	m_pDepthBufferPixels = new float[m_Width * m_Height];
+}
+
+RenderTarget::~RenderTarget()
+{
+	delete[] m_pDepthBufferPixels;
+
+	SDL_FreeSurface(m_pBackBuffer);
+}
+
+void RenderTarget::Lock()
+{
+	SDL_LockSurface(m_pBackBuffer);
+}
+
+void RenderTarget::Unlock()
+{
+	SDL_UnlockSurface(m_pBackBuffer);
+}
+
+bool RenderTarget::SaveToImage(const std::string& path) const
+{
+	return SDL_SaveBMP(m_pBackBuffer, path.c_str());
+}
+
+std::vector<uint32_t> RenderTarget::ReadPixels() const
+{
+	std::vector<uint32_t> pixels(static_cast<size_t>(m_Width) * m_Height);
+
+	Uint8 red{}, green{}, blue{};
+	for (size_t index{}; index < pixels.size(); ++index)
+	{
+		SDL_GetRGB(m_pBackBufferPixels[index], m_pBackBuffer->format, &red, &green, &blue);
+		pixels[index] = (red << 16) | (green << 8) | blue;
+	}
+
+	return pixels;
+}
+
+WindowRenderTarget::WindowRenderTarget(SDL_Window* pWindow) :
+	RenderTarget(GetWindowWidth(pWindow), GetWindowHeight(pWindow)),
+	m_pWindow{ pWindow },
+	m_pFrontBuffer{ SDL_GetWindowSurface(pWindow) }
+{
+}
+
+void WindowRenderTarget::Present()
+{
+	SDL_BlitSurface(GetBackBuffer(), 0, m_pFrontBuffer, 0);
+	SDL_UpdateWindowSurface(m_pWindow);
+}
+
+int WindowRenderTarget::GetWindowWidth(SDL_Window* pWindow)
+{
+	int width{};
+	SDL_GetWindowSize(pWindow, &width, nullptr);
+	return width;
+}
+
+int WindowRenderTarget::GetWindowHeight(SDL_Window* pWindow)
+{
+	int height{};
+	SDL_GetWindowSize(pWindow, nullptr, &height);
+	return height;
+}
+
+MemoryRenderTarget::MemoryRenderTarget(int width, int height) :
+	RenderTarget(width, height)
+{
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SDL_Window;
+struct SDL_Surface;
+
+namespace dae
+{
+	//Owns the color (back buffer) and depth buffer the Renderer draws into
+	class RenderTarget
+	{
+	public:
+		virtual ~RenderTarget();
+
+		RenderTarget(const RenderTarget&) = delete;
+		RenderTarget(RenderTarget&&) noexcept = delete;
+		RenderTarget& operator=(const RenderTarget&) = delete;
+		RenderTarget& operator=(RenderTarget&&) noexcept = delete;
+
+		void Lock();
+		void Unlock();
+
+		//Makes the finished back buffer visible, a no-op for offscreen targets
+		virtual void Present() {}
+
+		bool SaveToImage(const std::string& path) const;
+
+		//Copies the back buffer out as 0x00RRGGBB pixels, row by row
+		std::vector<uint32_t> ReadPixels() const;
+
+		int GetWidth() const { return m_Width; }
+		int GetHeight() const { return m_Height; }
+
+		SDL_Surface* GetBackBuffer() const { return m_pBackBuffer; }
+		uint32_t* GetBackBufferPixels() const { return m_pBackBufferPixels; }
+		float* GetDepthBufferPixels() const { return m_pDepthBufferPixels; }
+
+	protected:
+		RenderTarget(int width, int height);
+
+	private:
+		int m_Width{};
+		int m_Height{};
+
+		SDL_Surface* m_pBackBuffer{ nullptr };
+		uint32_t* m_pBackBufferPixels{};
+
+		float* m_pDepthBufferPixels{};
+	};
+
+	//Presents to the surface of an SDL_Window
+	class WindowRenderTarget final : public RenderTarget
+	{
+	public:
+		WindowRenderTarget(SDL_Window* pWindow);
+		~WindowRenderTarget() override = default;
+
+		void Present() override;
+
+	private:
+		static int GetWindowWidth(SDL_Window* pWindow);
+		static int GetWindowHeight(SDL_Window* pWindow);
+
+		SDL_Window* m_pWindow{};
+		SDL_Surface* m_pFrontBuffer{ nullptr };
+	};
+
+	//Offscreen target for headless rendering, does not need the SDL video subsystem
+	class MemoryRenderTarget final : public RenderTarget
+	{
+	public:
+		MemoryRenderTarget(int width, int height);
+		~MemoryRenderTarget() override = default;
+	};
+}
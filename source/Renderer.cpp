@@ -2,50 +2,159 @@
 #include "SDL.h"
 #include "SDL_surface.h"
 
+//Standard includes
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
 //Project includes
 #include "Renderer.h"
+#include "MaterialTexture.h"
 #include "Math.h"
 #include "Matrix.h"
+#include "MeshOptimizer.h"
+#include "RasterKernel.h"
+#include "RenderTarget.h"
+#include "ResolveKernel.h"
 #include "Texture.h"
+#include "ThreadPool.h"
 #include "Utils.h"
+#include "VertexKernel.h"
 
 using namespace dae;
 
-Renderer::Renderer(SDL_Window* pWindow) :
-	m_pWindow(pWindow)
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	float GetElapsedMilliseconds(const Clock::time_point& start)
+	{
+		return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+	}
+
+	//Raster space positions are snapped to 28.4 fixed point before triangle setup
+	constexpr int SubpixelBits{ 4 };
+	constexpr int SubpixelScale{ 1 << SubpixelBits };
+	constexpr int HalfPixel{ SubpixelScale / 2 };
+
+	//Far outside the guard band, so only degenerate vertices are rejected
+	//28.4 coordinates then stay below 2^18 and their differences below 2^19, so Int2 math cannot overflow
+	constexpr float MaxSnappedCoordinate{ 1 << 14 };
+
+	bool SnapToSubpixel(const Vector2& position, Int2& snapped)
+	{
+		if (!(std::abs(position.x) < MaxSnappedCoordinate && std::abs(position.y) < MaxSnappedCoordinate)) return false;
+
+		snapped.x = static_cast<int>(std::lround(position.x * SubpixelScale));
+		snapped.y = static_cast<int>(std::lround(position.y * SubpixelScale));
+		return true;
+	}
+
+	//Near and far in homogeneous space, x and y only against a guard band around the screen
+	//The guard band keeps snapped coordinates and edge weights in the range the raster stage handles exactly,
+	//anything inside it is left to the bounding box clamp and block rejection
+	constexpr int NrClipPlanes{ 6 };
+	constexpr float MaxGuardBand{ 2.f };
+
+	//Span weights are exact in float while no edge is 8192 pixels or taller, see RasterizeTriangle
+	//The guard band shrinks on larger render targets to keep clipped edges below that, with room for clipping and snapping rounding
+	constexpr float MaxGuardBandSize{ 8000.f };
+
+	float GetClipDistance(const Vector4& position, int plane, float guardBand)
+	{
+		switch (plane)
+		{
+		case 0: return position.z;						//Near, z >= 0
+		case 1: return position.w - position.z;			//Far, z <= w
+		case 2: return guardBand * position.w + position.x;
+		case 3: return guardBand * position.w - position.x;
+		case 4: return guardBand * position.w + position.y;
+		default: return guardBand * position.w - position.y;
+		}
+	}
+
+	//Twice the signed screen area, positive for the winding Utils::IsPixelInTriangle accepts
+	int64_t GetDoubleArea(const Int2& v0, const Int2& v1, const Int2& v2)
+	{
+		return static_cast<int64_t>(v2.x - v1.x) * (v0.y - v1.y) - static_cast<int64_t>(v2.y - v1.y) * (v0.x - v1.x);
+	}
+
+	//Largest factor the matrix scales a length with, for object space distances
+	float GetMaxScale(const Matrix& matrix)
+	{
+		return std::max(matrix.GetAxisX().Magnitude(), std::max(matrix.GetAxisY().Magnitude(), matrix.GetAxisZ().Magnitude()));
+	}
+}
+
+Renderer::Renderer(RenderTarget* pRenderTarget) :
+	m_pRenderTarget(pRenderTarget)
 {
 	//Initialize
-	SDL_GetWindowSize(pWindow, &m_Width, &m_Height);
+	m_Width = m_pRenderTarget->GetWidth();
+	m_Height = m_pRenderTarget->GetHeight();
+	m_GuardBand = std::clamp(MaxGuardBandSize / std::max(m_Width, m_Height), 1.f, MaxGuardBand);
+
+	//Buffers are owned by the render target
+	m_pBackBuffer = m_pRenderTarget->GetBackBuffer();
+	m_pBackBufferPixels = m_pRenderTarget->GetBackBufferPixels();
+
+	m_pDepthBufferPixels = m_pRenderTarget->GetDepthBufferPixels();
 
-	//Create Buffers
-	m_pFrontBuffer = SDL_GetWindowSurface(pWindow);
-	m_pBackBuffer = SDL_CreateRGBSurface(0, m_Width, m_Height, 32, 0, 0, 0, 0);
-	m_pBackBufferPixels = (uint32_t*)m_pBackBuffer->pixels;
+	//The back buffer format is fixed, so pixels are packed without asking SDL
+	m_PixelFormat = ResolveKernel::GetPixelFormat(m_pBackBuffer->format);
+	m_RedBuffer.resize(m_Width * m_Height);
+	m_GreenBuffer.resize(m_Width * m_Height);
+	m_BlueBuffer.resize(m_Width * m_Height);
 
-	m_pDepthBufferPixels = new float[m_Width * m_Height];
+	//Tiles
+	m_NrTilesX = (m_Width + m_TileSize - 1) / m_TileSize;
+	m_NrTilesY = (m_Height + m_TileSize - 1) / m_TileSize;
+
+	m_TileBins.resize(m_NrTilesX * m_NrTilesY);
+	m_TileStatistics.resize(m_TileBins.size());
+
+	m_TileMaxDepths.resize(m_TileBins.size());
+	m_BlockMaxDepths.resize(m_TileBins.size() * m_NrBlocksPerTileRow * m_NrBlocksPerTileRow);
+
+	m_pThreadPool = new ThreadPool();
+
+	SetInstructionSet(RasterKernel::DetectInstructionSet());
 
 	//Initialize Camera
 	m_Camera.Initialize(45.f, { 0.f,0.f,0.f }, m_Width / static_cast<float>(m_Height));
 
+	//The mesh and the material are loaded by the caller
 	m_MeshesWorld = { Mesh{} };
-
-	m_pDiffuseTexture = Texture::LoadFromFile("Resources/vehicle_diffuse.png");
-	m_pNormalTexture = Texture::LoadFromFile("Resources/vehicle_normal.png");
-	m_pGlossTexture = Texture::LoadFromFile("Resources/vehicle_gloss.png");
-	m_pSpecularTexture = Texture::LoadFromFile("Resources/vehicle_specular.png");
-
-	m_MeshesWorld[0].primitiveTopology = PrimitiveTopology::TriangleList;
-	Utils::ParseOBJ("Resources/vehicle.obj", m_MeshesWorld[0].vertices, m_MeshesWorld[0].indices);
 }
 
 Renderer::~Renderer()
 {
-	delete[] m_pDepthBufferPixels;
+	delete m_pThreadPool;
+
+	DeleteMaterial();
+}
 
+void Renderer::DeleteMaterial()
+{
+	delete m_pCompressedSpecularTexture;
+	delete m_pCompressedNormalTexture;
+	delete m_pCompressedGlossTexture;
+	delete m_pCompressedDiffuseTexture;
+	delete m_pMaterialTexture;
 	delete m_pSpecularTexture;
 	delete m_pNormalTexture;
 	delete m_pGlossTexture;
 	delete m_pDiffuseTexture;
+
+	m_pCompressedSpecularTexture = nullptr;
+	m_pCompressedNormalTexture = nullptr;
+	m_pCompressedGlossTexture = nullptr;
+	m_pCompressedDiffuseTexture = nullptr;
+	m_pMaterialTexture = nullptr;
+	m_pSpecularTexture = nullptr;
+	m_pNormalTexture = nullptr;
+	m_pGlossTexture = nullptr;
+	m_pDiffuseTexture = nullptr;
 }
 
 void Renderer::Update(Timer* pTimer)
@@ -54,62 +163,379 @@ void Renderer::Update(Timer* pTimer)
 
 	if (m_ShouldRotate)
 	{
-		m_RotationAngle += pTimer->GetElapsed();
-		m_MeshesWorld[0].worldMatrix = Matrix::CreateRotationY(m_RotationAngle) * Matrix::CreateTranslation(0.f, 0.f, 50.f);
+		SetRotationAngle(m_RotationAngle + pTimer->GetElapsed());
 	}
 }
 
 void Renderer::Render()
 {
+	//Nothing to shade with until LoadMaterial
+	if (!m_pDiffuseTexture) return;
+
+	//Nothing changed, the back buffer still holds this frame
+	if (!IsFrameDirty())
+	{
+		m_Statistics = {};
+		m_Statistics.isFrameReused = true;
+
+		const Clock::time_point presentStart{ Clock::now() };
+		m_pRenderTarget->Present();
+		m_Statistics.presentTime = GetElapsedMilliseconds(presentStart);
+		return;
+	}
+
 	//@START
 	//Lock BackBuffer
-	SDL_LockSurface(m_pBackBuffer);
+	m_pRenderTarget->Lock();
 
 	Render_W3_Part1();
+	m_IsFrameDirty = false;
+	m_Statistics.isFrameReused = false;
 
 	//@END
-	//Update SDL Surface
-	SDL_UnlockSurface(m_pBackBuffer);
-	SDL_BlitSurface(m_pBackBuffer, 0, m_pFrontBuffer, 0);
-	SDL_UpdateWindowSurface(m_pWindow);
+	//Update Render Target
+	const Clock::time_point presentStart{ Clock::now() };
+
+	m_pRenderTarget->Unlock();
+	m_pRenderTarget->Present();
+
+	m_Statistics.presentTime = GetElapsedMilliseconds(presentStart);
+}
+
+bool Renderer::IsFrameDirty() const
+{
+	if (m_IsFrameDirty || m_Camera.matrixVersion != m_TransformedCameraVersion)
+		return true;
+
+	for (const Mesh& mesh : m_MeshesWorld)
+	{
+		if (mesh.isTransformDirty)
+			return true;
+	}
+
+	return false;
 }
 
 void Renderer::VertexTransformationFunction(std::vector<Mesh>& meshes)
 {
+	//Transformed vertices stay valid until their mesh or the camera changes
+	const bool hasCameraChanged{ m_Camera.matrixVersion != m_TransformedCameraVersion };
+	m_TransformedCameraVersion = m_Camera.matrixVersion;
+	m_Statistics.nrTransformedVertices = 0;
+
 	for (Mesh& mesh : meshes)
 	{
-		mesh.vertices_out.resize(mesh.vertices.size());
+		if (!hasCameraChanged && !mesh.isTransformDirty)
+			continue;
 
-		const Matrix wordldViewProjectionMatrix{ mesh.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix };
-			
-		Vector4 position{};
+		mesh.isTransformDirty = false;
+		SelectLod(mesh);
+
+		//Meshlets outside the frustum or facing away skip the transform, the vertices only they use are left stale
+		const Matrix worldViewProjection{ mesh.worldMatrix * m_Camera.viewMatrix * m_Camera.projectionMatrix };
+		CullMeshlets(mesh, worldViewProjection);
+		BuildVertexBatches(mesh);
 
-		for (size_t index{}; index < mesh.vertices.size(); ++index)
+		mesh.positions_out.resize(mesh.vertices.size());
+		mesh.normals_out.resize(mesh.vertices.size());
+		mesh.tangents_out.resize(mesh.vertices.size());
+		mesh.viewDirections_out.resize(mesh.vertices.size());
+		mesh.positions_clip.resize(mesh.vertices.size());
+
+		VertexKernel::TransformInput input{};
+		input.pPositionX = mesh.vertexStreams.positionX.data();
+		input.pPositionY = mesh.vertexStreams.positionY.data();
+		input.pPositionZ = mesh.vertexStreams.positionZ.data();
+		input.pNormalX = mesh.vertexStreams.normalX.data();
+		input.pNormalY = mesh.vertexStreams.normalY.data();
+		input.pNormalZ = mesh.vertexStreams.normalZ.data();
+		input.pTangentX = mesh.vertexStreams.tangentX.data();
+		input.pTangentY = mesh.vertexStreams.tangentY.data();
+		input.pTangentZ = mesh.vertexStreams.tangentZ.data();
+		input.worldViewProjection = worldViewProjection;
+		input.world = mesh.worldMatrix;
+		input.cameraOrigin = m_Camera.origin;
+		input.width = static_cast<float>(m_Width);
+		input.height = static_cast<float>(m_Height);
+
+		const VertexKernel::TransformOutput output{ mesh.positions_clip.data(), mesh.positions_out.data(), mesh.normals_out.data(), mesh.tangents_out.data(), mesh.viewDirections_out.data() };
+
+		//World view projection, perspective divide, raster mapping and world space normals in one pass, in batches spread over the threads
+		m_pThreadPool->ParallelFor(m_VertexBatches.size(), [this, &input, &output](size_t batch)
+			{
+				m_TransformVertices(input, m_VertexBatches[batch].first, m_VertexBatches[batch].second, output);
+			});
+
+		for (const std::pair<size_t, size_t>& batch : m_VertexBatches)
+		{
+			m_Statistics.nrTransformedVertices += static_cast<uint32_t>(batch.second);
+		}
+	}
+}
+
+void Renderer::SelectLod(Mesh& mesh) const
+{
+	mesh.lodIndex = 0;
+	if (!m_UseLods || mesh.lods.empty()) return;
+
+	//Distance to the nearest point of the bounding sphere, the full mesh when the camera is inside it
+	const float worldScale{ GetMaxScale(mesh.worldMatrix) };
+	const float distance{ (mesh.worldMatrix.TransformPoint(mesh.boundingCenter) - m_Camera.origin).Magnitude() - mesh.boundingRadius * worldScale };
+	if (distance <= m_Camera.nearPlane) return;
+
+	//The coarsest level whose error stays below a pixel on screen at that distance
+	const float pixelsPerUnit{ 0.5f * m_Height / (m_Camera.fov * distance) };
+	for (size_t lodIndex{ mesh.lods.size() - 1 }; lodIndex > 0; --lodIndex)
+	{
+		if (mesh.lods[lodIndex].error * worldScale * pixelsPerUnit <= m_MaxLodError)
 		{
-			position = { mesh.vertices[index].position.x,mesh.vertices[index].position.y,mesh.vertices[index].position.z,0.f };
-			mesh.vertices_out[index].position = wordldViewProjectionMatrix.TransformPoint(position);
+			mesh.lodIndex = lodIndex;
+			return;
+		}
+	}
+}
+
+void Renderer::CullMeshlets(Mesh& mesh, const Matrix& worldViewProjection)
+{
+	mesh.visibleMeshlets.clear();
+	if (mesh.lods.empty()) return;
+
+	//Frustum planes in object space, a point p is inside plane i when Dot(normal, p) + distance >= 0
+	//Clip space x = Dot((p, 1), column 0) and so on, so the planes are sums of the columns of the matrix
+	Vector4 columns[4]{};
+	for (int column{}; column < 4; ++column)
+	{
+		columns[column] = { worldViewProjection[0][column], worldViewProjection[1][column], worldViewProjection[2][column], worldViewProjection[3][column] };
+	}
 
-			const float inverseW{ 1.f / mesh.vertices_out[index].position.w };
+	const Vector4 planes[6]
+	{
+		columns[2],					//Near, z >= 0
+		columns[3] - columns[2],	//Far, z <= w
+		columns[3] + columns[0],	//Left, x >= -w
+		columns[3] - columns[0],	//Right, x <= w
+		columns[3] + columns[1],	//Bottom, y >= -w
+		columns[3] - columns[1]		//Top, y <= w
+	};
 
-			//Positions
-			mesh.vertices_out[index].position.x *= inverseW;
-			mesh.vertices_out[index].position.y *= inverseW;
-			mesh.vertices_out[index].position.z *= inverseW;
-			mesh.vertices_out[index].position.w = inverseW;
+	Vector3 normals[6]{};
+	float distances[6]{};
+	for (int plane{}; plane < 6; ++plane)
+	{
+		const float magnitude{ Vector3{ planes[plane].x, planes[plane].y, planes[plane].z }.Magnitude() };
+		normals[plane] = Vector3{ planes[plane].x, planes[plane].y, planes[plane].z } / magnitude;
+		distances[plane] = planes[plane].w / magnitude;
+	}
 
-			//Normals
-			mesh.vertices_out[index].normal = mesh.worldMatrix.TransformVector(mesh.vertices[index].normal).Normalized();
-			mesh.vertices_out[index].tangent = mesh.worldMatrix.TransformVector(mesh.vertices[index].tangent).Normalized();
+	//Cones are tested in world space, with the radius grown by the largest scale of the world matrix
+	const float worldScale{ GetMaxScale(mesh.worldMatrix) };
+
+	//Back face culling rejects meshlets that face away as a whole, front face culling uses the flipped cone
+	const float coneSign{ m_CullMode == CullMode::Back ? 1.f : -1.f };
+
+	const MeshLod& lod{ mesh.lods[mesh.lodIndex] };
+	for (uint32_t meshletIndex{ lod.firstMeshlet }; meshletIndex < lod.firstMeshlet + lod.nrMeshlets; ++meshletIndex)
+	{
+		const Meshlet& meshlet{ mesh.meshlets[meshletIndex] };
 
-			//View
-			mesh.vertices_out[index].viewDirection = mesh.worldMatrix.TransformPoint(mesh.vertices[index].position) - m_Camera.origin;
+		bool isVisible{ true };
+		for (int plane{}; plane < 6 && isVisible; ++plane)
+		{
+			isVisible = Vector3::Dot(normals[plane], meshlet.center) + distances[plane] >= -meshlet.radius;
+		}
+
+		//Every point of the sphere sees all triangles from behind when its view direction is within the cone
+		if (isVisible && m_CullMode != CullMode::None && meshlet.coneCutoff < 1.f)
+		{
+			const Vector3 viewDirection{ mesh.worldMatrix.TransformPoint(meshlet.center) - m_Camera.origin };
+			const Vector3 coneAxis{ mesh.worldMatrix.TransformVector(meshlet.coneAxis).Normalized() };
+			isVisible = Vector3::Dot(viewDirection, coneAxis) * coneSign < meshlet.coneCutoff * viewDirection.Magnitude() + meshlet.radius * worldScale;
+		}
+
+		if (isVisible)
+			mesh.visibleMeshlets.push_back(meshletIndex);
+	}
+}
+
+void Renderer::BuildVertexBatches(const Mesh& mesh)
+{
+	m_VertexBatches.clear();
+
+	if (mesh.lods.empty())
+	{
+		for (size_t first{}; first < mesh.vertices.size(); first += m_VertexBatchSize)
+		{
+			m_VertexBatches.push_back({ first, std::min(m_VertexBatchSize, mesh.vertices.size() - first) });
 		}
+		return;
+	}
+
+	m_IsVertexUsed.assign(mesh.vertices.size(), false);
+	for (const uint32_t meshletIndex : mesh.visibleMeshlets)
+	{
+		const Meshlet& meshlet{ mesh.meshlets[meshletIndex] };
+		for (uint32_t vertex{ meshlet.firstVertex }; vertex < meshlet.firstVertex + meshlet.nrVertices; ++vertex)
+		{
+			m_IsVertexUsed[mesh.meshletVertices[vertex]] = true;
+		}
+	}
+
+	//Vertices are stored in the order the meshlets use them, so the used ones form a few long runs
+	for (size_t vertex{}; vertex < mesh.vertices.size();)
+	{
+		if (!m_IsVertexUsed[vertex])
+		{
+			++vertex;
+			continue;
+		}
+
+		const size_t first{ vertex };
+		while (vertex < mesh.vertices.size() && m_IsVertexUsed[vertex] && vertex - first < m_VertexBatchSize)
+		{
+			++vertex;
+		}
+
+		m_VertexBatches.push_back({ first, vertex - first });
+	}
+}
+
+void Renderer::BuildVertexStreams(Mesh& mesh)
+{
+	VertexStreams& streams{ mesh.vertexStreams };
+	streams = {};
+
+	for (const Vertex& vertex : mesh.vertices)
+	{
+		streams.positionX.push_back(vertex.position.x);
+		streams.positionY.push_back(vertex.position.y);
+		streams.positionZ.push_back(vertex.position.z);
+		streams.normalX.push_back(vertex.normal.x);
+		streams.normalY.push_back(vertex.normal.y);
+		streams.normalZ.push_back(vertex.normal.z);
+		streams.tangentX.push_back(vertex.tangent.x);
+		streams.tangentY.push_back(vertex.tangent.y);
+		streams.tangentZ.push_back(vertex.tangent.z);
 	}
 }
 
 bool Renderer::SaveBufferToImage() const
 {
-	return SDL_SaveBMP(m_pBackBuffer, "Rasterizer_ColorBuffer.bmp");
+	return m_pRenderTarget->SaveToImage("Rasterizer_ColorBuffer.bmp");
+}
+
+bool Renderer::LoadMesh(const std::string& objPath)
+{
+	Mesh& mesh{ m_MeshesWorld[0] };
+
+	mesh.primitiveTopology = PrimitiveTopology::TriangleList;
+	mesh.positions_out.clear();
+	mesh.isTransformDirty = true;
+
+	if (!Utils::ParseOBJ(objPath, mesh.vertices, mesh.indices))
+		return false;
+
+	//Triangles in vertex cache order, then vertices in the order those triangles use them
+	m_MeshStatistics.loadedACMR = MeshOptimizer::CalculateACMR(mesh.indices, mesh.vertices.size());
+	MeshOptimizer::OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+	MeshOptimizer::OptimizeVertexFetch(mesh.vertices, mesh.indices);
+	m_MeshStatistics.optimizedACMR = MeshOptimizer::CalculateACMR(mesh.indices, mesh.vertices.size());
+
+	m_MeshStatistics.nrIndices = mesh.indices.size();
+	m_MeshStatistics.nrVertices = mesh.vertices.size();
+
+	//Simplified levels of detail behind the full mesh, all sharing its vertices
+	MeshOptimizer::BuildLods(mesh);
+
+	m_MeshStatistics.nrLodTriangles.clear();
+	m_MeshStatistics.lodErrors.clear();
+	for (const MeshLod& lod : mesh.lods)
+	{
+		m_MeshStatistics.nrLodTriangles.push_back(lod.nrIndices / 3);
+		m_MeshStatistics.lodErrors.push_back(lod.error);
+	}
+
+	//Clusters of consecutive triangles, so every meshlet's vertices are mostly one run
+	MeshOptimizer::BuildMeshlets(mesh);
+	m_MeshStatistics.nrMeshlets = mesh.meshlets.size();
+
+	BuildVertexStreams(mesh);
+	return true;
+}
+
+bool Renderer::LoadMaterial(const MaterialPaths& paths, std::string& failedPath)
+{
+	Texture* pDiffuseTexture{ Texture::LoadFromFile(paths.diffuse) };
+	if (!pDiffuseTexture)
+	{
+		failedPath = paths.diffuse;
+		return false;
+	}
+
+	//Neutral maps have the diffuse map's size, so the four maps can still be interleaved
+	const MipLevel& size{ pDiffuseTexture->GetLevel(0) };
+	const auto load{ [&size](const std::string& path, const Texture::Texel& neutralTexel)
+		{
+			return path.empty() ? Texture::CreateSolid(size.width, size.height, neutralTexel) : Texture::LoadFromFile(path);
+		} };
+
+	//Zero gloss and specular leave only the diffuse term
+	Texture* pNormalTexture{ load(paths.normal, { 128, 128, 255, 255 }) };
+	Texture* pGlossTexture{ load(paths.gloss, { 0, 0, 0, 255 }) };
+	Texture* pSpecularTexture{ load(paths.specular, { 0, 0, 0, 255 }) };
+
+	if (!pNormalTexture || !pGlossTexture || !pSpecularTexture)
+	{
+		failedPath = !pNormalTexture ? paths.normal : (!pGlossTexture ? paths.gloss : paths.specular);
+
+		delete pSpecularTexture;
+		delete pGlossTexture;
+		delete pNormalTexture;
+		delete pDiffuseTexture;
+		return false;
+	}
+
+	DeleteMaterial();
+
+	m_pDiffuseTexture = pDiffuseTexture;
+	m_pNormalTexture = pNormalTexture;
+	m_pGlossTexture = pGlossTexture;
+	m_pSpecularTexture = pSpecularTexture;
+	m_pMaterialTexture = MaterialTexture::Create(*m_pDiffuseTexture, *m_pNormalTexture, *m_pGlossTexture, *m_pSpecularTexture);
+
+	//The specular map is tinted, so it keeps its color as BC1 at the same 4 bits per texel as BC4
+	m_pCompressedDiffuseTexture = Texture::CreateCompressed(*m_pDiffuseTexture, TextureFormat::BC1);
+	m_pCompressedNormalTexture = Texture::CreateCompressed(*m_pNormalTexture, TextureFormat::BC5);
+	m_pCompressedGlossTexture = Texture::CreateCompressed(*m_pGlossTexture, TextureFormat::BC4);
+	m_pCompressedSpecularTexture = Texture::CreateCompressed(*m_pSpecularTexture, TextureFormat::BC1);
+
+	m_IsFrameDirty = true;
+	return true;
+}
+
+void Renderer::SetThreadCount(size_t nrThreads)
+{
+	delete m_pThreadPool;
+	m_pThreadPool = new ThreadPool(nrThreads);
+}
+
+size_t Renderer::GetThreadCount() const
+{
+	return m_pThreadPool->GetThreadCount();
+}
+
+void Renderer::SetInstructionSet(RasterKernel::InstructionSet instructionSet)
+{
+	m_InstructionSet = instructionSet;
+	m_TestSpan = RasterKernel::GetSpanFunction(instructionSet);
+	m_TransformVertices = VertexKernel::GetTransformFunction(instructionSet);
+	m_ResolvePixels = ResolveKernel::GetResolveFunction(instructionSet);
+}
+
+void Renderer::SetRotationAngle(float angle)
+{
+	m_RotationAngle = angle;
+	m_MeshesWorld[0].worldMatrix = Matrix::CreateRotationY(m_RotationAngle) * Matrix::CreateTranslation(0.f, 0.f, m_MeshDistance);
+	m_MeshesWorld[0].isTransformDirty = true;
 }
 
 void dae::Renderer::ToggleRenderMode()
@@ -122,6 +548,8 @@ void dae::Renderer::ToggleRenderMode()
 	{
 		m_CurrentRenderMode = RenderMode::ObservedArea;
 	}
+
+	m_IsFrameDirty = true;
 }
 
 void dae::Renderer::ToggleRotation()
@@ -132,164 +560,850 @@ void dae::Renderer::ToggleRotation()
 void dae::Renderer::ToggleNormalMap()
 {
 	m_UseNormalMap = !m_UseNormalMap;
+	m_IsFrameDirty = true;
+}
+
+void Renderer::ToggleMaterialMode()
+{
+	if (m_MaterialMode < MaterialMode::Compressed)
+	{
+		SetMaterialMode(static_cast<MaterialMode>(static_cast<int>(m_MaterialMode) + 1));
+	}
+	else
+	{
+		SetMaterialMode(MaterialMode::Separate);
+	}
+}
+
+Renderer::MaterialMode Renderer::GetMaterialMode() const
+{
+	//Maps of different sizes are not interleaved
+	if (m_MaterialMode == MaterialMode::Packed && !m_pMaterialTexture)
+		return MaterialMode::Separate;
+
+	return m_MaterialMode;
+}
+
+size_t Renderer::GetMaterialMemorySize(MaterialMode materialMode) const
+{
+	switch (materialMode)
+	{
+	case MaterialMode::Packed:
+		return m_pMaterialTexture ? m_pMaterialTexture->GetMemorySize() : 0;
+	case MaterialMode::Compressed:
+		return m_pCompressedDiffuseTexture->GetMemorySize() + m_pCompressedNormalTexture->GetMemorySize() + m_pCompressedGlossTexture->GetMemorySize() + m_pCompressedSpecularTexture->GetMemorySize();
+	default:
+		return m_pDiffuseTexture->GetMemorySize() + m_pNormalTexture->GetMemorySize() + m_pGlossTexture->GetMemorySize() + m_pSpecularTexture->GetMemorySize();
+	}
+}
+
+void dae::Renderer::ToggleCullMode()
+{
+	if (m_CullMode < CullMode::Front)
+	{
+		SetCullMode(static_cast<CullMode>(static_cast<int>(m_CullMode) + 1));
+	}
+	else
+	{
+		SetCullMode(CullMode::None);
+	}
+}
+
+void Renderer::SetMeshDistance(float distance)
+{
+	m_MeshDistance = distance;
+	SetRotationAngle(m_RotationAngle);
+}
+
+void Renderer::SetUseLods(bool shouldUse)
+{
+	m_UseLods = shouldUse;
+	m_IsFrameDirty = true;
+
+	//Levels are picked together with the meshlet culling
+	for (Mesh& mesh : m_MeshesWorld)
+	{
+		mesh.isTransformDirty = true;
+	}
+}
+
+void Renderer::SetCullMode(CullMode cullMode)
+{
+	m_CullMode = cullMode;
+	m_IsFrameDirty = true;
+
+	//The meshlets that survive culling depend on the cull mode
+	for (Mesh& mesh : m_MeshesWorld)
+	{
+		mesh.isTransformDirty = true;
+	}
 }
 
 void Renderer::Render_W3_Part1()
 {
-	const int nrPixels{ m_Width * m_Height };
-	std::fill_n(m_pDepthBufferPixels, nrPixels, INFINITY);
+	Clock::time_point stageStart{ Clock::now() };
+
+	if (m_UseVisibilityBuffer)
+		m_VisibilityBuffer.resize(m_Width * m_Height);
+
+	//Every tile row clears its own band of the buffers, the colors are cleared per tile
+	m_pThreadPool->ParallelFor(m_NrTilesY, [this](size_t tileY)
+		{
+			const int firstPixel{ static_cast<int>(tileY) * m_TileSize * m_Width };
+			const int nrPixels{ std::min(m_TileSize, m_Height - static_cast<int>(tileY) * m_TileSize) * m_Width };
+
+			std::fill_n(m_pDepthBufferPixels + firstPixel, nrPixels, INFINITY);
+
+			if (m_UseVisibilityBuffer)
+				std::fill_n(m_VisibilityBuffer.begin() + firstPixel, nrPixels, VisibilitySample{ m_NoTriangle });
+
+			const size_t firstTile{ tileY * m_NrTilesX };
+			const size_t nrBlocksPerTile{ m_NrBlocksPerTileRow * m_NrBlocksPerTileRow };
+			std::fill_n(m_TileMaxDepths.begin() + firstTile, m_NrTilesX, INFINITY);
+			std::fill_n(m_BlockMaxDepths.begin() + firstTile * nrBlocksPerTile, m_NrTilesX * nrBlocksPerTile, INFINITY);
+		});
 
-	SDL_FillRect(m_pBackBuffer, NULL, SDL_MapRGB(m_pBackBuffer->format, 100, 100, 100));
+	m_Statistics.clearTime = GetElapsedMilliseconds(stageStart);
+	stageStart = Clock::now();
 
 	VertexTransformationFunction(m_MeshesWorld);
 
-	for (Mesh& mesh : m_MeshesWorld)
+	m_Statistics.vertexTransformationTime = GetElapsedMilliseconds(stageStart);
+	stageStart = Clock::now();
+
+	BinTriangles();
+	SelectPixelShader();
+
+	std::fill(m_TileStatistics.begin(), m_TileStatistics.end(), RenderStatistics{});
+	m_pThreadPool->ParallelFor(m_TileBins.size(), [this](size_t tileIndex) { RenderTile(tileIndex); });
+
+	float totalShadingTime{};
+	m_Statistics.nrFillRuleSkips = 0;
+	m_Statistics.nrRejectedBlocks = 0;
+	m_Statistics.nrAcceptedBlocks = 0;
+	m_Statistics.nrCoverageTests = 0;
+	m_Statistics.nrOccludedTiles = 0;
+	m_Statistics.nrOccludedBlocks = 0;
+	m_Statistics.nrShadedFragments = 0;
+
+	for (const RenderStatistics& tileStatistics : m_TileStatistics)
+	{
+		totalShadingTime += tileStatistics.pixelShadingTime;
+		m_Statistics.nrFillRuleSkips += tileStatistics.nrFillRuleSkips;
+		m_Statistics.nrRejectedBlocks += tileStatistics.nrRejectedBlocks;
+		m_Statistics.nrAcceptedBlocks += tileStatistics.nrAcceptedBlocks;
+		m_Statistics.nrCoverageTests += tileStatistics.nrCoverageTests;
+		m_Statistics.nrOccludedTiles += tileStatistics.nrOccludedTiles;
+		m_Statistics.nrOccludedBlocks += tileStatistics.nrOccludedBlocks;
+		m_Statistics.nrShadedFragments += tileStatistics.nrShadedFragments;
+	}
+
+	//Shading time is summed over all tiles, spread it over the threads to get its share of the wall time
+	m_Statistics.pixelShadingTime = totalShadingTime / m_pThreadPool->GetThreadCount();
+	m_Statistics.rasterizationTime = std::max(0.f, GetElapsedMilliseconds(stageStart) - m_Statistics.pixelShadingTime);
+}
+
+void Renderer::BinTriangles()
+{
+	m_Statistics.nrCulledTriangles = 0;
+	m_Statistics.nrClippedTriangles = 0;
+	m_Statistics.nrCulledMeshlets = 0;
+	m_Statistics.nrLodTriangles = 0;
+
+	m_BinnedTriangles.clear();
+	for (std::vector<uint32_t>& bin : m_TileBins)
+	{
+		bin.clear();
+	}
+
+	m_ClippedMesh.vertices.clear();
+	m_ClippedMesh.positions_out.clear();
+	m_ClippedMesh.normals_out.clear();
+	m_ClippedMesh.tangents_out.clear();
+	m_ClippedMesh.viewDirections_out.clear();
+	m_ClippedMesh.indices.clear();
+
+	for (const Mesh& mesh : m_MeshesWorld)
 	{
-		for (size_t index{}; index < mesh.vertices.size(); ++index)
+		if (mesh.lods.empty())
 		{
-			//NDC space -> Raster space
-			mesh.vertices_out[index].position.x = 0.5f * (mesh.vertices_out[index].position.x + 1.f) * m_Width;
-			mesh.vertices_out[index].position.y = 0.5f * (1.f - mesh.vertices_out[index].position.y) * m_Height;
+			BinTriangles(mesh, 0, mesh.indices.size());
+			continue;
 		}
 
-		const bool isTriangleList{ mesh.primitiveTopology == PrimitiveTopology::TriangleList };
+		//Only the triangles of the meshlets that survived culling, in submission order
+		m_Statistics.nrLodTriangles += mesh.lods[mesh.lodIndex].nrIndices / 3;
+		m_Statistics.nrCulledMeshlets += mesh.lods[mesh.lodIndex].nrMeshlets - static_cast<uint32_t>(mesh.visibleMeshlets.size());
+		for (const uint32_t meshletIndex : mesh.visibleMeshlets)
+		{
+			const Meshlet& meshlet{ mesh.meshlets[meshletIndex] };
+			BinTriangles(mesh, meshlet.firstIndex, meshlet.firstIndex + meshlet.nrIndices);
+		}
+	}
+}
+
+void Renderer::BinTriangles(const Mesh& mesh, size_t firstIndex, size_t lastIndex)
+{
+	const bool isTriangleList{ mesh.primitiveTopology == PrimitiveTopology::TriangleList };
+
+	const size_t increment{ isTriangleList ? 3u : 1u };
+	const size_t maxCount{ isTriangleList ? lastIndex : std::max(lastIndex, size_t{ 2 }) - 2 };  //Max = lastIndex bij triangleList of lastIndex - 2 bij triangleStrip
+
+	for (size_t index{ firstIndex }; index < maxCount; index += increment)
+	{
+		if (mesh.indices[index] == mesh.indices[index + 1] || mesh.indices[index] == mesh.indices[index + 2] || mesh.indices[index + 1] == mesh.indices[index + 2]) continue;
+
+		const bool shouldSwap{ !isTriangleList && index & 0x01 };
+
+		//Frustum culling in clip space, a vertex outside a plane has a negative distance to it
+		uint32_t outsideMasks[3]{};
+		for (int vertex{}; vertex < 3; ++vertex)
+		{
+			const Vector4& position{ mesh.positions_clip[mesh.indices[index + vertex]] };
+			for (int plane{}; plane < NrClipPlanes; ++plane)
+			{
+				outsideMasks[vertex] |= (GetClipDistance(position, plane, m_GuardBand) < 0.f) << plane;
+			}
+		}
 
-		const int increment{ isTriangleList * 3 + !isTriangleList * 1 };
-		const int maxCount{ static_cast<int>(mesh.indices.size()) + !isTriangleList * (-2) };  //Max = nrIndices + 0 bij triangleStrip of -2 bij triangleList
+		//All vertices outside the same plane
+		if (outsideMasks[0] & outsideMasks[1] & outsideMasks[2]) continue;
 
-		for (size_t index{}; index < maxCount; index += increment)
+		if (outsideMasks[0] | outsideMasks[1] | outsideMasks[2])
 		{
-			//Frustrum culling
-			if (mesh.vertices_out[mesh.indices[index]].position.z < 0.f || mesh.vertices_out[mesh.indices[index]].position.z > 1.f ||
-				mesh.vertices_out[mesh.indices[index + 1]].position.z < 0.f || mesh.vertices_out[mesh.indices[index + 1]].position.z > 1.f ||
-				mesh.vertices_out[mesh.indices[index + 2]].position.z < 0.f || mesh.vertices_out[mesh.indices[index + 2]].position.z > 1.f) continue;
+			++m_Statistics.nrClippedTriangles;
+			ClipTriangle(mesh, index, shouldSwap);
+			continue;
+		}
+
+		BinTriangle(mesh, index, shouldSwap);
+	}
+}
 
-			if (mesh.indices[index] == mesh.indices[index + 1] || mesh.indices[index] == mesh.indices[index + 2] || mesh.indices[index + 1] == mesh.indices[index + 2]) continue;
+void Renderer::ClipTriangle(const Mesh& mesh, size_t index, bool shouldSwap)
+{
+	//Sutherland-Hodgman in clip space, every polygon vertex is kept as its weights of the three triangle vertices
+	//Attributes are linear in clip space, so the same weights interpolate them afterwards
+	struct ClipVertex
+	{
+		Vector4 position{};
+		Vector3 weights{};
+	};
 
-			const Vector2 v0{ mesh.vertices_out[mesh.indices[index]].position.GetXY() };
-			const Vector2 v1{ mesh.vertices_out[mesh.indices[index + 1]].position.GetXY() };
-			const Vector2 v2{ mesh.vertices_out[mesh.indices[index + 2]].position.GetXY() };
+	//A triangle clipped by n planes has at most 3 + n vertices
+	ClipVertex polygon[3 + NrClipPlanes]{};
+	ClipVertex clipped[3 + NrClipPlanes]{};
+	int nrVertices{ 3 };
 
-			Vector2 min{ std::min(v0.x, v1.x),std::min(v0.y, v1.y) };
-			min.x = std::min(min.x, v2.x);
-			min.y = std::min(min.y, v2.y);
+	polygon[0] = { mesh.positions_clip[mesh.indices[index]], { 1.f, 0.f, 0.f } };
+	polygon[1] = { mesh.positions_clip[mesh.indices[index + 1]], { 0.f, 1.f, 0.f } };
+	polygon[2] = { mesh.positions_clip[mesh.indices[index + 2]], { 0.f, 0.f, 1.f } };
+
+	for (int plane{}; plane < NrClipPlanes && nrVertices > 0; ++plane)
+	{
+		int nrClipped{};
+		for (int vertex{}; vertex < nrVertices; ++vertex)
+		{
+			const ClipVertex& current{ polygon[vertex] };
+			const ClipVertex& next{ polygon[(vertex + 1) % nrVertices] };
 
-			Vector2 max{ std::max(v0.x, v1.x),std::max(v0.y, v1.y) };
-			max.x = std::max(max.x, v2.x);
-			max.y = std::max(max.y, v2.y);
+			const float currentDistance{ GetClipDistance(current.position, plane, m_GuardBand) };
+			const float nextDistance{ GetClipDistance(next.position, plane, m_GuardBand) };
 
+			if (currentDistance >= 0.f)
+				clipped[nrClipped++] = current;
 
-			//RENDER LOGIC
-			for (int px{ std::max(0,static_cast<int>(min.x)) }; px <= std::min(m_Width - 1, static_cast<int>(max.x)); ++px)
+			//The edge crosses the plane
+			if ((currentDistance >= 0.f) != (nextDistance >= 0.f))
 			{
-				for (int py{ std::max(0,static_cast<int>(min.y)) }; py <= std::min(m_Height - 1, static_cast<int>(max.y)); ++py)
-				{
-					/*m_pBackBufferPixels[static_cast<int>(px) + (static_cast<int>(py) * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-						static_cast<uint8_t>(255),
-						static_cast<uint8_t>(255),
-						static_cast<uint8_t>(255));			// boundingbox visualization
-					continue;*/
+				const float t{ currentDistance / (currentDistance - nextDistance) };
+				clipped[nrClipped++] = { current.position + (next.position - current.position) * t, current.weights + (next.weights - current.weights) * t };
+			}
+		}
+
+		std::copy(clipped, clipped + nrClipped, polygon);
+		nrVertices = nrClipped;
+	}
+
+	if (nrVertices < 3) return;
+
+	//Clipped vertices go into a triangle list of their own, in the original winding
+	const uint32_t firstVertex{ static_cast<uint32_t>(m_ClippedMesh.vertices.size()) };
+
+	const uint32_t i0{ mesh.indices[index] };
+	const uint32_t i1{ mesh.indices[index + 1] };
+	const uint32_t i2{ mesh.indices[index + 2] };
+
+	for (int vertex{}; vertex < nrVertices; ++vertex)
+	{
+		const Vector3& weights{ polygon[vertex].weights };
+
+		Vertex clippedVertex{};
+		clippedVertex.position = mesh.vertices[i0].position * weights.x + mesh.vertices[i1].position * weights.y + mesh.vertices[i2].position * weights.z;
+		clippedVertex.color = mesh.vertices[i0].color * weights.x + mesh.vertices[i1].color * weights.y + mesh.vertices[i2].color * weights.z;
+		clippedVertex.uv = mesh.vertices[i0].uv * weights.x + mesh.vertices[i1].uv * weights.y + mesh.vertices[i2].uv * weights.z;
+		m_ClippedMesh.vertices.push_back(clippedVertex);
+
+		m_ClippedMesh.normals_out.push_back(mesh.normals_out[i0] * weights.x + mesh.normals_out[i1] * weights.y + mesh.normals_out[i2] * weights.z);
+		m_ClippedMesh.tangents_out.push_back(mesh.tangents_out[i0] * weights.x + mesh.tangents_out[i1] * weights.y + mesh.tangents_out[i2] * weights.z);
+		m_ClippedMesh.viewDirections_out.push_back(mesh.viewDirections_out[i0] * weights.x + mesh.viewDirections_out[i1] * weights.y + mesh.viewDirections_out[i2] * weights.z);
+
+		//Same perspective divide and NDC -> raster conversion as the unclipped vertices
+		const Vector4& position{ polygon[vertex].position };
+		const float inverseW{ 1.f / position.w };
+		m_ClippedMesh.positions_out.push_back(
+			{
+				0.5f * (position.x * inverseW + 1.f) * m_Width,
+				0.5f * (1.f - position.y * inverseW) * m_Height,
+				position.z * inverseW,
+				inverseW
+			});
+	}
+
+	//Triangle fan, the odd triangles of a strip are flipped to keep their facing
+	for (int vertex{ 1 }; vertex + 1 < nrVertices; ++vertex)
+	{
+		const size_t firstIndex{ m_ClippedMesh.indices.size() };
+
+		m_ClippedMesh.indices.push_back(firstVertex);
+		m_ClippedMesh.indices.push_back(firstVertex + (shouldSwap ? vertex + 1 : vertex));
+		m_ClippedMesh.indices.push_back(firstVertex + (shouldSwap ? vertex : vertex + 1));
+
+		BinTriangle(m_ClippedMesh, firstIndex, false);
+	}
+}
+
+void Renderer::BinTriangle(const Mesh& mesh, size_t index, bool shouldSwap)
+{
+	Int2 v0{}, v1{}, v2{};
+	if (!SnapToSubpixel(mesh.positions_out[mesh.indices[index]].GetXY(), v0) ||
+		!SnapToSubpixel(mesh.positions_out[mesh.indices[index + 1]].GetXY(), v1) ||
+		!SnapToSubpixel(mesh.positions_out[mesh.indices[index + 2]].GetXY(), v2)) return;
+
+	//Face culling on the signed area, computed once per triangle
+	//Front faces have the winding Utils::IsPixelInTriangle accepts, which flips for the odd triangles of a strip
+	const int64_t area{ GetDoubleArea(v0, v1, v2) };
+	const bool isFrontFace{ (area > 0) != shouldSwap };
+
+	if ((m_CullMode == CullMode::Back && !isFrontFace) || (m_CullMode == CullMode::Front && isFrontFace))
+	{
+		++m_Statistics.nrCulledTriangles;
+		return;
+	}
 
-					Vector3 vertexRatio{};
+	//Pixels whose center lies within the snapped bounds
+	BinnedTriangle triangle{ &mesh, index };
+	triangle.minX = std::max(0, (std::min(v0.x, std::min(v1.x, v2.x)) - HalfPixel + SubpixelScale - 1) >> SubpixelBits);
+	triangle.minY = std::max(0, (std::min(v0.y, std::min(v1.y, v2.y)) - HalfPixel + SubpixelScale - 1) >> SubpixelBits);
+	triangle.maxX = std::min(m_Width - 1, (std::max(v0.x, std::max(v1.x, v2.x)) - HalfPixel) >> SubpixelBits);
+	triangle.maxY = std::min(m_Height - 1, (std::max(v0.y, std::max(v1.y, v2.y)) - HalfPixel) >> SubpixelBits);
 
-					//Rasterization
-					if (!Utils::IsPixelInTriangle(Vector2{ static_cast<float>(px),static_cast<float>(py) }, v0, v1, v2, vertexRatio, !isTriangleList && index & 0x01)) continue;
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) return;
 
+	triangle.minDepth = std::min(mesh.positions_out[mesh.indices[index]].z, std::min(mesh.positions_out[mesh.indices[index + 1]].z, mesh.positions_out[mesh.indices[index + 2]].z));
+
+	//Triangle setup
+	if (!SetupEdgeFunctions(v0, v1, v2, area, triangle)) return;
+
+	//Triangles are appended in submission order, so every tile still resolves equal depths the same way
+	const uint32_t triangleIndex{ static_cast<uint32_t>(m_BinnedTriangles.size()) };
+	m_BinnedTriangles.push_back(triangle);
+
+	for (int tileY{ triangle.minY / m_TileSize }; tileY <= triangle.maxY / m_TileSize; ++tileY)
+	{
+		for (int tileX{ triangle.minX / m_TileSize }; tileX <= triangle.maxX / m_TileSize; ++tileX)
+		{
+			m_TileBins[tileX + tileY * m_NrTilesX].push_back(triangleIndex);
+		}
+	}
+}
+
+bool Renderer::SetupEdgeFunctions(const Int2& v0, const Int2& v1, const Int2& v2, int64_t area, BinnedTriangle& triangle)
+{
+	//A triangle without area has no pixel on the inner side of all three edges
+	if (area == 0) return false;
+
+	//Orient the edges so the inside is positive for either winding
+	const int64_t orientation{ area > 0 ? 1 : -1 };
+	area *= orientation;
+
+	//Center of the first pixel in the bounds
+	const int64_t originX{ static_cast<int64_t>(triangle.minX) * SubpixelScale + HalfPixel };
+	const int64_t originY{ static_cast<int64_t>(triangle.minY) * SubpixelScale + HalfPixel };
+
+	const Int2* pVertices[3]{ &v0, &v1, &v2 };
+	for (int edge{}; edge < 3; ++edge)
+	{
+		//Same cross product as Utils::IsPixelInTriangle: Cross(end - start, pixel - start), exact in fixed point
+		const Int2& start{ *pVertices[(edge + 1) % 3] };
+		const Int2& end{ *pVertices[(edge + 2) % 3] };
+
+		const int64_t stepX{ orientation * (start.y - end.y) };
+		const int64_t stepY{ orientation * (end.x - start.x) };
+
+		triangle.edgeStepX[edge] = stepX * SubpixelScale;
+		triangle.edgeStepY[edge] = stepY * SubpixelScale;
+		triangle.edgeWeight[edge] = stepX * (originX - start.x) + stepY * (originY - start.y);
+
+		//Top-left rule: a pixel center exactly on an edge only belongs to the triangle if that edge is a left edge
+		//(the inside lies to its right) or a top edge (horizontal with the inside below it, y points down)
+		const bool isTopLeft{ stepX > 0 || (stepX == 0 && stepY > 0) };
+		triangle.edgeBias[edge] = isTopLeft ? 0 : 1;
+	}
+
+	triangle.inverseArea = 1.f / static_cast<float>(area);
+	return true;
+}
+
+void Renderer::RenderTile(size_t tileIndex)
+{
+	//Only this tile's pixels are written, so tiles need no synchronization
+	const int tileMinX{ static_cast<int>(tileIndex % m_NrTilesX) * m_TileSize };
+	const int tileMinY{ static_cast<int>(tileIndex / m_NrTilesX) * m_TileSize };
+	const int tileMaxX{ std::min(tileMinX + m_TileSize, m_Width) - 1 };
+	const int tileMaxY{ std::min(tileMinY + m_TileSize, m_Height) - 1 };
+
+	//Shading writes the color planes, a tile without triangles only needs the clear color in the back buffer
+	const bool hasTriangles{ !m_TileBins[tileIndex].empty() };
+	const int nrTilePixelsX{ tileMaxX - tileMinX + 1 };
+	for (int py{ tileMinY }; py <= tileMaxY; ++py)
+	{
+		const int firstPixel{ tileMinX + py * m_Width };
+		if (hasTriangles)
+		{
+			std::fill_n(m_RedBuffer.begin() + firstPixel, nrTilePixelsX, m_ClearColor);
+			std::fill_n(m_GreenBuffer.begin() + firstPixel, nrTilePixelsX, m_ClearColor);
+			std::fill_n(m_BlueBuffer.begin() + firstPixel, nrTilePixelsX, m_ClearColor);
+		}
+		else
+		{
+			const uint8_t clearColor{ static_cast<uint8_t>(m_ClearColor) };
+			std::fill_n(m_pBackBufferPixels + firstPixel, nrTilePixelsX, ResolveKernel::PackColor(m_PixelFormat, clearColor, clearColor, clearColor));
+		}
+	}
+
+	RenderStatistics& tileStatistics{ m_TileStatistics[tileIndex] };
+	float& tileMaxDepth{ m_TileMaxDepths[tileIndex] };
+	float* pBlockMaxDepths{ &m_BlockMaxDepths[tileIndex * m_NrBlocksPerTileRow * m_NrBlocksPerTileRow] };
+
+	for (const uint32_t triangleIndex : m_TileBins[tileIndex])
+	{
+		const BinnedTriangle& triangle{ m_BinnedTriangles[triangleIndex] };
+
+		//Everything already drawn in this tile is closer than the triangle
+		if (triangle.minDepth > tileMaxDepth)
+		{
+			++tileStatistics.nrOccludedTiles;
+			continue;
+		}
+
+		const bool hasWrittenDepth{ RasterizeTriangle(triangleIndex,
+			std::max(triangle.minX, tileMinX), std::max(triangle.minY, tileMinY),
+			std::min(triangle.maxX, tileMaxX), std::min(triangle.maxY, tileMaxY),
+			pBlockMaxDepths, tileStatistics) };
+
+		if (!hasWrittenDepth) continue;
+
+		//The tile is as far as its farthest block
+		const int nrBlocksX{ (tileMaxX - tileMinX) / m_BlockSize + 1 };
+		const int nrBlocksY{ (tileMaxY - tileMinY) / m_BlockSize + 1 };
+
+		tileMaxDepth = 0.f;
+		for (int blockY{}; blockY < nrBlocksY; ++blockY)
+		{
+			for (int blockX{}; blockX < nrBlocksX; ++blockX)
+			{
+				tileMaxDepth = std::max(tileMaxDepth, pBlockMaxDepths[blockX + blockY * m_NrBlocksPerTileRow]);
+			}
+		}
+	}
+
+	if (m_UseVisibilityBuffer)
+	{
+		const Clock::time_point shadingStart{ Clock::now() };
+		ShadeVisibilityBuffer(tileMinX, tileMinY, tileMaxX, tileMaxY, tileStatistics);
+		tileStatistics.pixelShadingTime += GetElapsedMilliseconds(shadingStart);
+	}
+
+	//Resolve: pack the finished tile into the back buffer
+	if (hasTriangles)
+	{
+		const ResolveKernel::ResolveInput input{ m_RedBuffer.data(), m_GreenBuffer.data(), m_BlueBuffer.data() };
+		for (int py{ tileMinY }; py <= tileMaxY; ++py)
+		{
+			m_ResolvePixels(input, tileMinX + py * m_Width, nrTilePixelsX, m_PixelFormat, m_pBackBufferPixels);
+		}
+	}
+}
+
+bool Renderer::RasterizeTriangle(uint32_t triangleIndex, int minX, int minY, int maxX, int maxY, float* pBlockMaxDepths, RenderStatistics& tileStatistics)
+{
+	const BinnedTriangle& triangle{ m_BinnedTriangles[triangleIndex] };
+	const Mesh& mesh{ *triangle.pMesh };
+	const size_t index{ triangle.firstIndex };
+	bool hasWrittenDepth{ false };
 
-					//Attribute Interpolation
-					const float currentDepth{ 1.f / ((vertexRatio.x / mesh.vertices_out[mesh.indices[index]].position.z) + (vertexRatio.y / mesh.vertices_out[mesh.indices[index + 1]].position.z) + (vertexRatio.z / mesh.vertices_out[mesh.indices[index + 2]].position.z)) };
+	RasterKernel::SpanInput span{};
+	span.inverseArea = triangle.inverseArea;
 
-					if (currentDepth < m_pDepthBufferPixels[px + (py * m_Width)])
+	for (int edge{}; edge < 3; ++edge)
+	{
+		span.stepX[edge] = static_cast<float>(triangle.edgeStepX[edge]);
+		span.bias[edge] = static_cast<float>(triangle.edgeBias[edge]);
+		span.depth[edge] = mesh.positions_out[mesh.indices[index + edge]].z;
+	}
+
+	RasterKernel::SpanOutput result{};
+
+	//Walk the bounding box in blocks on the screen's 8x8 grid, one span per block row
+	//An edge function is linear, so its extremes over a block are in the block's corners
+	for (int blockY{ minY & ~(m_BlockSize - 1) }; blockY <= maxY; blockY += m_BlockSize)
+	{
+		const int firstY{ std::max(blockY, minY) };
+		const int lastY{ std::min(blockY + m_BlockSize - 1, maxY) };
+
+		for (int blockX{ minX & ~(m_BlockSize - 1) }; blockX <= maxX; blockX += m_BlockSize)
+		{
+			const int firstX{ std::max(blockX, minX) };
+			const int lastX{ std::min(blockX + m_BlockSize - 1, maxX) };
+
+			//Blocks are on the screen grid and tiles are a whole number of blocks, so the block lies within this tile
+			float& blockMaxDepth{ pBlockMaxDepths[(blockX % m_TileSize) / m_BlockSize + (blockY % m_TileSize) / m_BlockSize * m_NrBlocksPerTileRow] };
+
+			int64_t blockWeight[3]{};
+			bool isOutside{ false };
+			bool isInside{ true };
+
+			for (int edge{}; edge < 3; ++edge)
+			{
+				const int64_t offsetX{ triangle.edgeStepX[edge] * (lastX - firstX) };
+				const int64_t offsetY{ triangle.edgeStepY[edge] * (lastY - firstY) };
+
+				blockWeight[edge] = triangle.edgeWeight[edge] - triangle.edgeBias[edge] + triangle.edgeStepX[edge] * (firstX - triangle.minX) + triangle.edgeStepY[edge] * (firstY - triangle.minY);
+
+				const int64_t minWeight{ blockWeight[edge] + std::min(int64_t{}, offsetX) + std::min(int64_t{}, offsetY) };
+				const int64_t maxWeight{ blockWeight[edge] + std::max(int64_t{}, offsetX) + std::max(int64_t{}, offsetY) };
+
+				isOutside |= maxWeight < 0;
+				isInside &= minWeight >= 0;
+			}
+
+			//Trivial reject: every pixel of the block is outside one of the edges
+			if (isOutside)
+			{
+				++tileStatistics.nrRejectedBlocks;
+				continue;
+			}
+
+			if (triangle.minDepth > blockMaxDepth)
+			{
+				++tileStatistics.nrOccludedBlocks;
+				continue;
+			}
+
+			//Trivial accept: every pixel is inside all edges, only the depth test is left
+			span.isCovered = isInside;
+			if (isInside)
+				++tileStatistics.nrAcceptedBlocks;
+			else
+				tileStatistics.nrCoverageTests += (lastX - firstX + 1) * (lastY - firstY + 1);
+
+			const int nrPixels{ lastX - firstX + 1 };
+			bool hasWrittenBlock{ false };
+
+			for (int py{ firstY }; py <= lastY; ++py)
+			{
+				//The exact integer weights are only rounded to float once per span, at its first lane
+				//A lane on an edge is at most 7 pixels further, so that first weight is below 8 * 256 * the edge's height in pixels,
+				//exact below 2^24 as long as the guard band keeps edges under 8192 pixels tall; the lane steps are multiples of 256 and exact too
+				span.weight[0] = static_cast<float>(blockWeight[0]);
+				span.weight[1] = static_cast<float>(blockWeight[1]);
+				span.weight[2] = static_cast<float>(blockWeight[2]);
+
+				blockWeight[0] += triangle.edgeStepY[0];
+				blockWeight[1] += triangle.edgeStepY[1];
+				blockWeight[2] += triangle.edgeStepY[2];
+
+				//Rasterization and depth test for the whole span at once
+				uint32_t passedMask{ m_TestSpan(span, nrPixels, m_pDepthBufferPixels + py * m_Width + firstX, result) };
+
+				tileStatistics.nrFillRuleSkips += std::popcount(result.fillRuleMask);
+				hasWrittenBlock |= passedMask != 0;
+
+				//Shade the pixels that were written to the depth buffer, or only remember them when shading is deferred
+				for (int lane{}; passedMask != 0; ++lane, passedMask >>= 1)
+				{
+					if (!(passedMask & 1)) continue;
+
+					if (m_UseVisibilityBuffer)
 					{
-						m_pDepthBufferPixels[px + (py * m_Width)] = currentDepth;
-
-						const float wInterpolated{ 1.f / ((vertexRatio.x * mesh.vertices_out[mesh.indices[index]].position.w) + (vertexRatio.y * mesh.vertices_out[mesh.indices[index + 1]].position.w) + (vertexRatio.z * mesh.vertices_out[mesh.indices[index + 2]].position.w)) };
-
-						Vertex_Out pixel
-						{
-							Vector4//position
-							{
-								static_cast<float>(px),
-								static_cast<float>(py),
-								currentDepth,
-								wInterpolated
-							},
-							ColorRGB //color
-							{
-								(mesh.vertices[mesh.indices[index]].color * vertexRatio.x * mesh.vertices_out[mesh.indices[index]].position.w + mesh.vertices[mesh.indices[index + 1]].color * vertexRatio.y * mesh.vertices_out[mesh.indices[index + 1]].position.w + mesh.vertices[mesh.indices[index + 2]].color * vertexRatio.z * mesh.vertices_out[mesh.indices[index + 2]].color) * wInterpolated
-							},
-							Vector2 //uv
-							{
-								(mesh.vertices[mesh.indices[index]].uv * vertexRatio.x * mesh.vertices_out[mesh.indices[index]].position.w + mesh.vertices[mesh.indices[index + 1]].uv * vertexRatio.y * mesh.vertices_out[mesh.indices[index + 1]].position.w + mesh.vertices[mesh.indices[index + 2]].uv * vertexRatio.z * mesh.vertices_out[mesh.indices[index + 2]].position.w) * wInterpolated
-							},
-							Vector3 //normal
-							{
-								((mesh.vertices_out[mesh.indices[index]].normal * vertexRatio.x * mesh.vertices_out[mesh.indices[index]].position.w + mesh.vertices_out[mesh.indices[index + 1]].normal * vertexRatio.y * mesh.vertices_out[mesh.indices[index + 1]].position.w + mesh.vertices_out[mesh.indices[index + 2]].normal * vertexRatio.z * mesh.vertices_out[mesh.indices[index + 2]].position.w) * wInterpolated).Normalized()
-							},
-							Vector3 //tangent
-							{
-								((mesh.vertices_out[mesh.indices[index]].tangent * vertexRatio.x * mesh.vertices_out[mesh.indices[index]].position.w + mesh.vertices_out[mesh.indices[index + 1]].tangent * vertexRatio.y * mesh.vertices_out[mesh.indices[index + 1]].position.w + mesh.vertices_out[mesh.indices[index + 2]].tangent * vertexRatio.z * mesh.vertices_out[mesh.indices[index + 2]].position.w) * wInterpolated).Normalized()
-							},
-							Vector3 //viewDirection
-							{
-								((mesh.vertices_out[mesh.indices[index]].viewDirection * vertexRatio.x * mesh.vertices_out[mesh.indices[index]].position.w + mesh.vertices_out[mesh.indices[index + 1]].viewDirection * vertexRatio.y * mesh.vertices_out[mesh.indices[index + 1]].position.w + mesh.vertices_out[mesh.indices[index + 2]].viewDirection * vertexRatio.z * mesh.vertices_out[mesh.indices[index + 2]].position.w) * wInterpolated).Normalized()
-							}
-						};
-
-						PixelShading(pixel);
+						m_VisibilityBuffer[firstX + lane + py * m_Width] = { triangleIndex, result.ratio0[lane], result.ratio1[lane], result.ratio2[lane] };
+						continue;
 					}
+
+					const Vector3 vertexRatio{ result.ratio0[lane], result.ratio1[lane], result.ratio2[lane] };
+					ShadeFragment(triangle, firstX + lane, py, result.depth[lane], vertexRatio, tileStatistics);
 				}
 			}
+
+			//Depths only got closer, recompute over the whole block to lower its Hi-Z
+			if (hasWrittenBlock)
+			{
+				blockMaxDepth = GetMaxDepth(blockX, blockY, std::min(blockX + m_BlockSize, m_Width) - 1, std::min(blockY + m_BlockSize, m_Height) - 1);
+				hasWrittenDepth = true;
+			}
 		}
 	}
+
+	return hasWrittenDepth;
+}
+
+float Renderer::GetMaxDepth(int minX, int minY, int maxX, int maxY) const
+{
+	float maxDepth{};
+	for (int py{ minY }; py <= maxY; ++py)
+	{
+		const float* pDepthRow{ m_pDepthBufferPixels + py * m_Width };
+		maxDepth = std::max(maxDepth, *std::max_element(pDepthRow + minX, pDepthRow + maxX + 1));
+	}
+
+	return maxDepth;
 }
 
+void Renderer::ShadeVisibilityBuffer(int minX, int minY, int maxX, int maxY, RenderStatistics& tileStatistics)
+{
+	for (int py{ minY }; py <= maxY; ++py)
+	{
+		for (int px{ minX }; px <= maxX; ++px)
+		{
+			const int pixelIndex{ px + py * m_Width };
+			const VisibilitySample& sample{ m_VisibilityBuffer[pixelIndex] };
+			if (sample.triangleIndex == m_NoTriangle) continue;
+
+			const BinnedTriangle& triangle{ m_BinnedTriangles[sample.triangleIndex] };
+			const Vector3 vertexRatio{ sample.ratio0, sample.ratio1, sample.ratio2 };
+			ShadeFragment(triangle, px, py, m_pDepthBufferPixels[pixelIndex], vertexRatio, tileStatistics);
+		}
+	}
+}
+
+void Renderer::ShadeFragment(const BinnedTriangle& triangle, int px, int py, float currentDepth, const Vector3& vertexRatio, RenderStatistics& tileStatistics)
+{
+	++tileStatistics.nrShadedFragments;
+
+	const Mesh& mesh{ *triangle.pMesh };
+	const size_t index{ triangle.firstIndex };
+
+	//Attribute Interpolation, only now the attribute streams are read
+	const uint32_t i0{ mesh.indices[index] };
+	const uint32_t i1{ mesh.indices[index + 1] };
+	const uint32_t i2{ mesh.indices[index + 2] };
+
+	const float w0{ mesh.positions_out[i0].w };
+	const float w1{ mesh.positions_out[i1].w };
+	const float w2{ mesh.positions_out[i2].w };
+
+	const float wInterpolated{ 1.f / ((vertexRatio.x * w0) + (vertexRatio.y * w1) + (vertexRatio.z * w2)) };
+
+	Vertex_Out pixel
+	{
+		Vector4//position
+		{
+			static_cast<float>(px),
+			static_cast<float>(py),
+			currentDepth,
+			wInterpolated
+		},
+		ColorRGB //color
+		{
+			(mesh.vertices[i0].color * vertexRatio.x * w0 + mesh.vertices[i1].color * vertexRatio.y * w1 + mesh.vertices[i2].color * vertexRatio.z * w2) * wInterpolated
+		},
+		Vector2 //uv
+		{
+			(mesh.vertices[i0].uv * vertexRatio.x * w0 + mesh.vertices[i1].uv * vertexRatio.y * w1 + mesh.vertices[i2].uv * vertexRatio.z * w2) * wInterpolated
+		},
+		Vector3 //normal
+		{
+			((mesh.normals_out[i0] * vertexRatio.x * w0 + mesh.normals_out[i1] * vertexRatio.y * w1 + mesh.normals_out[i2] * vertexRatio.z * w2) * wInterpolated).Normalized()
+		},
+		Vector3 //tangent
+		{
+			((mesh.tangents_out[i0] * vertexRatio.x * w0 + mesh.tangents_out[i1] * vertexRatio.y * w1 + mesh.tangents_out[i2] * vertexRatio.z * w2) * wInterpolated).Normalized()
+		},
+		Vector3 //viewDirection
+		{
+			((mesh.viewDirections_out[i0] * vertexRatio.x * w0 + mesh.viewDirections_out[i1] * vertexRatio.y * w1 + mesh.viewDirections_out[i2] * vertexRatio.z * w2) * wInterpolated).Normalized()
+		}
+	};
+
+	if (m_ShaderNeedsUVDerivatives)
+	{
+		//Coarse derivatives: uv at the top left pixel of the 2x2 quad and at its right and lower neighbours, also when those lie outside the triangle
+		//The barycentric ratios are linear in screen space, uv is their perspective correct blend
+		const Vector2 uv0{ mesh.vertices[i0].uv * w0 };
+		const Vector2 uv1{ mesh.vertices[i1].uv * w1 };
+		const Vector2 uv2{ mesh.vertices[i2].uv * w2 };
+
+		const float stepX0{ triangle.edgeStepX[0] * triangle.inverseArea };
+		const float stepX1{ triangle.edgeStepX[1] * triangle.inverseArea };
+		const float stepX2{ triangle.edgeStepX[2] * triangle.inverseArea };
+		const float stepY0{ triangle.edgeStepY[0] * triangle.inverseArea };
+		const float stepY1{ triangle.edgeStepY[1] * triangle.inverseArea };
+		const float stepY2{ triangle.edgeStepY[2] * triangle.inverseArea };
+
+		const float quadOffsetX{ -static_cast<float>(px & 1) };
+		const float quadOffsetY{ -static_cast<float>(py & 1) };
+		const float ratio0{ vertexRatio.x + stepX0 * quadOffsetX + stepY0 * quadOffsetY };
+		const float ratio1{ vertexRatio.y + stepX1 * quadOffsetX + stepY1 * quadOffsetY };
+		const float ratio2{ vertexRatio.z + stepX2 * quadOffsetX + stepY2 * quadOffsetY };
+
+		const Vector2 numerator{ uv0 * ratio0 + uv1 * ratio1 + uv2 * ratio2 };
+		const float denominator{ ratio0 * w0 + ratio1 * w1 + ratio2 * w2 };
+		const Vector2 numeratorStepX{ uv0 * stepX0 + uv1 * stepX1 + uv2 * stepX2 };
+		const float denominatorStepX{ stepX0 * w0 + stepX1 * w1 + stepX2 * w2 };
+		const Vector2 numeratorStepY{ uv0 * stepY0 + uv1 * stepY1 + uv2 * stepY2 };
+		const float denominatorStepY{ stepY0 * w0 + stepY1 * w1 + stepY2 * w2 };
+
+		//A neighbour far enough outside the triangle can reach the vanishing line, the pixel then keeps level 0
+		if (denominator > 0.f && denominator + denominatorStepX > 0.f && denominator + denominatorStepY > 0.f)
+		{
+			const Vector2 quadUV{ numerator / denominator };
+			pixel.uvDerivativeX = (numerator + numeratorStepX) / (denominator + denominatorStepX) - quadUV;
+			pixel.uvDerivativeY = (numerator + numeratorStepY) / (denominator + denominatorStepY) - quadUV;
+		}
+	}
+
+	if (m_MeasurePixelShading && !m_UseVisibilityBuffer)
+	{
+		const Clock::time_point shadingStart{ Clock::now() };
+		(this->*m_PixelShader)(pixel);
+		tileStatistics.pixelShadingTime += GetElapsedMilliseconds(shadingStart);
+	}
+	else
+	{
+		(this->*m_PixelShader)(pixel);
+	}
+}
+
+template <Renderer::RenderMode Mode, bool UseNormalMap, Renderer::MaterialMode Material, bool UseMipmaps>
 void Renderer::PixelShading(const Vertex_Out& v)
 {
+	constexpr bool useDiffuse{ Mode == RenderMode::Diffuse || Mode == RenderMode::Combined };
+	constexpr bool useSpecular{ Mode == RenderMode::Specular || Mode == RenderMode::Combined };
+
 	ColorRGB finalColor{};
 
-	const Vector3 binominal{ Vector3::Cross(v.normal,v.tangent) };
-	const Matrix tangentSpaceAxis{ v.tangent,binominal,v.normal,Vector3::Zero };
+	//The packed material fetches every map at once, the separate maps are only sampled when this variant uses them
+	constexpr bool usePackedMaterial{ Material == MaterialMode::Packed && (UseNormalMap || useDiffuse || useSpecular) };
+	const auto sample{ [&v](const auto* pTexture)
+		{
+			if constexpr (UseMipmaps)
+				return pTexture->Sample(v.uv, v.uvDerivativeX, v.uvDerivativeY);
+			else
+				return pTexture->Sample(v.uv);
+		} };
+	const auto sampleMap{ [&sample](const Texture* pTexture, const Texture* pCompressedTexture)
+		{
+			if constexpr (Material == MaterialMode::Compressed)
+				return sample(pCompressedTexture);
+			else
+				return sample(pTexture);
+		} };
 
-	const ColorRGB normalMapSample{ m_pNormalTexture->Sample(v.uv) };
+	MaterialSample material{};
+	if constexpr (usePackedMaterial)
+		material = sample(m_pMaterialTexture);
+
+	Vector3 sampledNormal{ v.normal };
+	if constexpr (UseNormalMap)
+	{
+		if constexpr (!usePackedMaterial)
+			material.normal = sampleMap(m_pNormalTexture, m_pCompressedNormalTexture);
 
-	Vector3 sampledNormal{ 2.f * normalMapSample.m_pRed - 1.f,2.f * normalMapSample.m_pGreen - 1.f,2.f * normalMapSample.m_pBlue - 1.f };
-	sampledNormal = (m_UseNormalMap ? tangentSpaceAxis.TransformVector(sampledNormal).Normalized() : v.normal);
+		const Vector3 binominal{ Vector3::Cross(v.normal,v.tangent) };
+		const Matrix tangentSpaceAxis{ v.tangent,binominal,v.normal,Vector3::Zero };
+
+		sampledNormal = tangentSpaceAxis.TransformVector({ 2.f * material.normal.m_pRed - 1.f,2.f * material.normal.m_pGreen - 1.f,2.f * material.normal.m_pBlue - 1.f }).Normalized();
+	}
 
 	const float observedArea{ Vector3::Dot(sampledNormal,-m_LightDirection) };
 
 	if (observedArea > 0.f)
 	{
-		const ColorRGB diffuse{ (m_LightIntensity * m_pDiffuseTexture->Sample(v.uv)) / PI };
-
-		ColorRGB specular{ (m_pSpecularTexture->Sample(v.uv)) * powf(std::max(Vector3::Dot(-m_LightDirection - (2.f * std::max(Vector3::Dot(sampledNormal, -m_LightDirection), 0.f) * sampledNormal), v.viewDirection), 0.f), m_Shininess * m_pGlossTexture->Sample(v.uv).m_pRed) };
+		ColorRGB diffuse{};
+		if constexpr (useDiffuse)
+		{
+			if constexpr (!usePackedMaterial)
+				material.diffuse = sampleMap(m_pDiffuseTexture, m_pCompressedDiffuseTexture);
 
-		specular.m_pRed = std::max(0.f, specular.m_pRed);
-		specular.m_pGreen = std::max(0.f, specular.m_pGreen);
-		specular.m_pBlue = std::max(0.f, specular.m_pBlue);
+			diffuse = (m_LightIntensity * material.diffuse) / PI;
+		}
 
-		switch (m_CurrentRenderMode)
+		ColorRGB specular{};
+		if constexpr (useSpecular)
 		{
-		case dae::Renderer::RenderMode::Combined:
+			if constexpr (!usePackedMaterial)
+			{
+				material.specular = sampleMap(m_pSpecularTexture, m_pCompressedSpecularTexture);
+				material.gloss = sampleMap(m_pGlossTexture, m_pCompressedGlossTexture).m_pRed;
+			}
+
+			//observedArea is positive here, so it is the clamped cosine of the reflection
+			specular = material.specular * powf(std::max(Vector3::Dot(-m_LightDirection - (2.f * observedArea * sampledNormal), v.viewDirection), 0.f), m_Shininess * material.gloss);
+
+			specular.m_pRed = std::max(0.f, specular.m_pRed);
+			specular.m_pGreen = std::max(0.f, specular.m_pGreen);
+			specular.m_pBlue = std::max(0.f, specular.m_pBlue);
+		}
+
+		if constexpr (Mode == RenderMode::Combined)
 			finalColor = observedArea * (diffuse + specular + m_Ambient);
-			break;
-		case dae::Renderer::RenderMode::ObservedArea:
+		else if constexpr (Mode == RenderMode::ObservedArea)
 			finalColor = { observedArea,observedArea,observedArea };
-			break;
-		case dae::Renderer::RenderMode::Diffuse:
+		else if constexpr (Mode == RenderMode::Diffuse)
 			finalColor = observedArea * diffuse;
-			break;
-		case dae::Renderer::RenderMode::Specular:
+		else
 			finalColor = observedArea * specular;
-			break;
-		}
 	}
 
-	//Update Color in Buffer
+	//Update Color in Buffer, the tile resolve packs it
 	finalColor.MaxToOne();
 
-	m_pBackBufferPixels[static_cast<int>(v.position.x) + (static_cast<int>(v.position.y) * m_Width)] = SDL_MapRGB(m_pBackBuffer->format,
-		static_cast<uint8_t>(finalColor.m_pRed * 255),
-		static_cast<uint8_t>(finalColor.m_pGreen * 255),
-		static_cast<uint8_t>(finalColor.m_pBlue * 255));
+	const int pixelIndex{ static_cast<int>(v.position.x) + (static_cast<int>(v.position.y) * m_Width) };
+	m_RedBuffer[pixelIndex] = finalColor.m_pRed * 255;
+	m_GreenBuffer[pixelIndex] = finalColor.m_pGreen * 255;
+	m_BlueBuffer[pixelIndex] = finalColor.m_pBlue * 255;
+}
+
+void Renderer::SelectPixelShader()
+{
+	//Indexed by render mode, then by normal map use
+	using PixelShaderGetter = PixelShader(*)(MaterialMode materialMode, bool useMipmaps);
+	static constexpr PixelShaderGetter pixelShaderGetters[][2]
+	{
+		{ &Renderer::GetPixelShader<RenderMode::ObservedArea, false>, &Renderer::GetPixelShader<RenderMode::ObservedArea, true> },
+		{ &Renderer::GetPixelShader<RenderMode::Diffuse, false>, &Renderer::GetPixelShader<RenderMode::Diffuse, true> },
+		{ &Renderer::GetPixelShader<RenderMode::Specular, false>, &Renderer::GetPixelShader<RenderMode::Specular, true> },
+		{ &Renderer::GetPixelShader<RenderMode::Combined, false>, &Renderer::GetPixelShader<RenderMode::Combined, true> }
+	};
+
+	m_PixelShader = pixelShaderGetters[static_cast<int>(m_CurrentRenderMode)][m_UseNormalMap](GetMaterialMode(), m_UseMipmaps);
+
+	//Only the observed area without normal map reads no texture, it needs no uv derivatives
+	const bool samplesTextures{ m_UseNormalMap || m_CurrentRenderMode != RenderMode::ObservedArea };
+	m_ShaderNeedsUVDerivatives = m_UseMipmaps && samplesTextures;
+}
+
+template <Renderer::RenderMode Mode, bool UseNormalMap>
+Renderer::PixelShader Renderer::GetPixelShader(MaterialMode materialMode, bool useMipmaps)
+{
+	//Indexed by material mode, then by mipmap use
+	static constexpr PixelShader pixelShaders[][2]
+	{
+		{ &Renderer::PixelShading<Mode, UseNormalMap, MaterialMode::Separate, false>, &Renderer::PixelShading<Mode, UseNormalMap, MaterialMode::Separate, true> },
+		{ &Renderer::PixelShading<Mode, UseNormalMap, MaterialMode::Packed, false>, &Renderer::PixelShading<Mode, UseNormalMap, MaterialMode::Packed, true> },
+		{ &Renderer::PixelShading<Mode, UseNormalMap, MaterialMode::Compressed, false>, &Renderer::PixelShading<Mode, UseNormalMap, MaterialMode::Compressed, true> }
+	};
+
+	return pixelShaders[static_cast<int>(materialMode)][useMipmaps];
 }
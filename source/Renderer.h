@@ -1,26 +1,95 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "Camera.h"
 #include "DataTypes.h"
+#include "RasterKernel.h"
+#include "ResolveKernel.h"
+#include "VertexKernel.h"
 
-struct SDL_Window;
 struct SDL_Surface;
 
 namespace dae
 {
+	class MaterialTexture;
+	class RenderTarget;
 	class Texture;
+	class ThreadPool;
 	struct Mesh;
 	struct Vertex;
 	class Timer;
 	class Scene;
 
+	//Time spent in each pipeline stage during the last Render call, in milliseconds
+	struct RenderStatistics
+	{
+		float clearTime{};
+		float vertexTransformationTime{};
+		float rasterizationTime{};
+		float pixelShadingTime{};
+		float presentTime{};
+
+		//Pixels on a shared edge that the top-left rule kept from being depth tested and shaded a second time
+		uint32_t nrFillRuleSkips{};
+
+		//8x8 blocks that were skipped or accepted whole, and pixels that still needed a coverage test
+		uint32_t nrRejectedBlocks{};
+		uint32_t nrAcceptedBlocks{};
+		uint32_t nrCoverageTests{};
+
+		//Triangle parts that the Hi-Z rejected for a whole tile or block
+		uint32_t nrOccludedTiles{};
+		uint32_t nrOccludedBlocks{};
+
+		//Calls to the pixel shader, equal to the visible pixels when the visibility buffer is used
+		uint32_t nrShadedFragments{};
+
+		//Triangles dropped by face culling before triangle setup
+		uint32_t nrCulledTriangles{};
+
+		//Triangles that crossed the near or far plane or the guard band and were clipped
+		uint32_t nrClippedTriangles{};
+
+		//Vertices transformed this frame, meshes that did not move and an unchanged camera reuse the last results
+		uint32_t nrTransformedVertices{};
+
+		//Meshlets outside the frustum or facing away as a whole, their vertices and triangles are skipped
+		uint32_t nrCulledMeshlets{};
+
+		//Triangles in the levels of detail picked this frame, before any culling
+		uint32_t nrLodTriangles{};
+
+		//Nothing changed since the last frame, so it was presented again without rendering
+		bool isFrameReused{ false };
+	};
+
+	//Reported by LoadMesh
+	struct MeshStatistics
+	{
+		//Every face corner is an index, corners that share all attributes share a vertex
+		size_t nrIndices{};
+		size_t nrVertices{};
+
+		//Post-transform vertex cache misses per triangle, as loaded and after reordering
+		float loadedACMR{};
+		float optimizedACMR{};
+
+		//Clusters of at most MeshOptimizer::MaxMeshletVertices vertices and MaxMeshletTriangles triangles, over all levels of detail
+		size_t nrMeshlets{};
+
+		//Triangles and object space error of every level of detail, level 0 is the full mesh
+		std::vector<size_t> nrLodTriangles{};
+		std::vector<float> lodErrors{};
+	};
+
 	class Renderer final
 	{
 	public:
-		Renderer(SDL_Window* pWindow);
+		Renderer(RenderTarget* pRenderTarget);
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -33,26 +102,107 @@ namespace dae
 
 		bool SaveBufferToImage() const;
 
+		//Render draws nothing until a mesh and a material are loaded
+		bool LoadMesh(const std::string& objPath);
+
+		//Surface maps PixelShading reads, the diffuse map is required
+		//An empty path gets a neutral map of the diffuse map's size: a flat normal, or no gloss and specular
+		struct MaterialPaths
+		{
+			std::string diffuse{};
+			std::string normal{};
+			std::string gloss{};
+			std::string specular{};
+		};
+
+		//Replaces the current maps, on failure failedPath is the file that did not load and the current maps are kept
+		bool LoadMaterial(const MaterialPaths& paths, std::string& failedPath);
+
+		const MeshStatistics& GetMeshStatistics() const { return m_MeshStatistics; }
+		void SetRotationAngle(float angle);
+		void SetMeshDistance(float distance);
+
+		//Visibility buffer shading is timed per tile. Forward shading is interleaved with rasterization and can only be timed per fragment,
+		//which adds two clock reads to every fragment, so it is only measured on request and otherwise counted as rasterization
+		void SetMeasurePixelShading(bool shouldMeasure) { m_MeasurePixelShading = shouldMeasure; }
+		const RenderStatistics& GetStatistics() const { return m_Statistics; }
+
+		//0 uses one thread per hardware core
+		void SetThreadCount(size_t nrThreads);
+		size_t GetThreadCount() const;
+
+		//Defaults to the best instruction set the CPU supports
+		void SetInstructionSet(RasterKernel::InstructionSet instructionSet);
+		RasterKernel::InstructionSet GetInstructionSet() const { return m_InstructionSet; }
+
 		void ToggleRenderMode();
 		void ToggleRotation();
 		void ToggleNormalMap();
 
+		//Rasterizes triangle IDs and barycentrics first and shades every visible pixel once afterwards
+		void ToggleVisibilityBuffer() { SetUseVisibilityBuffer(!m_UseVisibilityBuffer); }
+		void SetUseVisibilityBuffer(bool shouldUse) { m_UseVisibilityBuffer = shouldUse; m_IsFrameDirty = true; }
+		bool GetUseVisibilityBuffer() const { return m_UseVisibilityBuffer; }
+
+		//Picks a simplified level of detail per mesh when its error would be smaller than a pixel
+		void ToggleLods() { SetUseLods(!m_UseLods); }
+		void SetUseLods(bool shouldUse);
+		bool GetUseLods() const { return m_UseLods; }
+
+		//Where the surface maps are sampled from: the four maps one by one, the interleaved material texture in one fetch,
+		//or block compressed copies of the four maps that are decoded per texel
+		enum class MaterialMode { Separate, Packed, Compressed };
+		void ToggleMaterialMode();
+		void SetMaterialMode(MaterialMode materialMode) { m_MaterialMode = materialMode; m_IsFrameDirty = true; }
+		MaterialMode GetMaterialMode() const;
+
+		//Texel storage of all mip levels the given mode samples from, in bytes
+		size_t GetMaterialMemorySize(MaterialMode materialMode) const;
+
+		//Trilinear sampling of the mip chains instead of the nearest texel of the full size textures
+		void ToggleMipmaps() { SetUseMipmaps(!m_UseMipmaps); }
+		void SetUseMipmaps(bool shouldUse) { m_UseMipmaps = shouldUse; m_IsFrameDirty = true; }
+		bool GetUseMipmaps() const { return m_UseMipmaps; }
+
+		enum class CullMode { None, Back, Front };
+		void ToggleCullMode();
+		void SetCullMode(CullMode cullMode);
+		CullMode GetCullMode() const { return m_CullMode; }
+
 	private:
-		SDL_Window* m_pWindow{};
+		RenderTarget* m_pRenderTarget{};
 
-		SDL_Surface* m_pFrontBuffer{ nullptr };
 		SDL_Surface* m_pBackBuffer{ nullptr };
 		uint32_t* m_pBackBufferPixels{};
 
 		float* m_pDepthBufferPixels{};
 
+		//Shaded colors in 0-255, one plane per channel, packed into the back buffer per tile
+		std::vector<float> m_RedBuffer{};
+		std::vector<float> m_GreenBuffer{};
+		std::vector<float> m_BlueBuffer{};
+		static constexpr float m_ClearColor{ 100.f };
+		ResolveKernel::PixelFormat m_PixelFormat{};
+
 		Camera m_Camera{};
 
-		//Textures
-		Texture* m_pDiffuseTexture;
-		Texture* m_pGlossTexture;
-		Texture* m_pNormalTexture;
-		Texture* m_pSpecularTexture;
+		//Textures, set by LoadMaterial
+		Texture* m_pDiffuseTexture{ nullptr };
+		Texture* m_pGlossTexture{ nullptr };
+		Texture* m_pNormalTexture{ nullptr };
+		Texture* m_pSpecularTexture{ nullptr };
+
+		//The four maps above interleaved, nullptr when their sizes differ
+		MaterialTexture* m_pMaterialTexture{ nullptr };
+
+		//The four maps above block compressed: BC1 diffuse and specular, BC5 normal, BC4 gloss
+		Texture* m_pCompressedDiffuseTexture{ nullptr };
+		Texture* m_pCompressedGlossTexture{ nullptr };
+		Texture* m_pCompressedNormalTexture{ nullptr };
+		Texture* m_pCompressedSpecularTexture{ nullptr };
+
+		MaterialMode m_MaterialMode{ MaterialMode::Packed };
+		bool m_UseMipmaps{ true };
 
 		//Shading
 		const Vector3 m_LightDirection{ 0.577f,-0.577f,0.577f };
@@ -60,15 +210,98 @@ namespace dae
 		const float m_Shininess{ 25.f };
 		const ColorRGB m_Ambient{ 0.025f,0.025f,0.025f };
 
-		//Window Size
+		//Render Target Size
 		int m_Width{};
 		int m_Height{};
 
+		//Clip space x and y limit, a multiple of w
+		float m_GuardBand{ 2.f };
+
 		std::vector<Mesh> m_MeshesWorld;
 
+		//Tiles
+		//Triangles are binned into square screen tiles, every tile is rasterized by exactly one thread
+		static constexpr int m_TileSize{ 64 };
+		int m_NrTilesX{};
+		int m_NrTilesY{};
+
+		//Tiles are walked in blocks of one span by one span, blocks fully outside or inside a triangle skip the per pixel coverage test
+		static constexpr int m_BlockSize{ RasterKernel::SpanWidth };
+		static constexpr int m_NrBlocksPerTileRow{ m_TileSize / m_BlockSize };
+
+		struct BinnedTriangle
+		{
+			const Mesh* pMesh{};
+			size_t firstIndex{};
+
+			//Screen bounds, clamped to the render target
+			int minX{};
+			int minY{};
+			int maxX{};
+			int maxY{};
+
+			//Nearest vertex depth, no pixel of the triangle can be closer
+			float minDepth{};
+
+			//Edge functions in 28.4 fixed point, sampled at pixel centers:
+			//weight[i] = edgeWeight[i] + edgeStepX[i] * (px - minX) + edgeStepY[i] * (py - minY)
+			//Edge i lies opposite vertex i, so weight[i] * inverseArea is that vertex's barycentric ratio
+			int64_t edgeStepX[3]{};
+			int64_t edgeStepY[3]{};
+			int64_t edgeWeight[3]{};
+			float inverseArea{};
+
+			//1 for edges that do not own the pixels exactly on them (top-left rule)
+			int edgeBias[3]{};
+		};
+
+		std::vector<BinnedTriangle> m_BinnedTriangles{};
+
+		//Triangle list of this frame's clipped triangles, already in raster space
+		Mesh m_ClippedMesh{};
+		std::vector<std::vector<uint32_t>> m_TileBins{};
+		std::vector<RenderStatistics> m_TileStatistics{};
+
+		//Hi-Z: farthest depth stored in every tile and in every block of it, blocks are stored per tile
+		//Only lowered by recomputing from the depth buffer, so a triangle behind it is always fully hidden
+		std::vector<float> m_TileMaxDepths{};
+		std::vector<float> m_BlockMaxDepths{};
+
+		//Visibility buffer, the closest triangle per pixel with the barycentric ratios it was depth tested with
+		struct VisibilitySample
+		{
+			uint32_t triangleIndex{};
+			float ratio0{};
+			float ratio1{};
+			float ratio2{};
+		};
+
+		static constexpr uint32_t m_NoTriangle{ UINT32_MAX };
+		bool m_UseVisibilityBuffer{ false };
+		std::vector<VisibilitySample> m_VisibilityBuffer{};
+
+		ThreadPool* m_pThreadPool{ nullptr };
+
+		RasterKernel::InstructionSet m_InstructionSet{ RasterKernel::InstructionSet::Scalar };
+		RasterKernel::SpanFunction m_TestSpan{ &RasterKernel::TestSpanScalar };
+		VertexKernel::TransformFunction m_TransformVertices{ &VertexKernel::TransformScalar };
+		ResolveKernel::ResolveFunction m_ResolvePixels{ &ResolveKernel::ResolveScalar };
+
+		//Vertices per vertex transform job
+		static constexpr size_t m_VertexBatchSize{ 4096 };
+
+		//Vertices used by the visible meshlets, and the runs of them that get transformed as (first, count)
+		std::vector<uint8_t> m_IsVertexUsed{};
+		std::vector<std::pair<size_t, size_t>> m_VertexBatches{};
+
 		//Rotation
 		bool m_ShouldRotate{ true };
 		float m_RotationAngle{};
+		float m_MeshDistance{ 50.f };
+
+		//Levels of detail
+		bool m_UseLods{ true };
+		static constexpr float m_MaxLodError{ 1.f }; //Pixels
 
 		//Normal Map
 		bool m_UseNormalMap{ true };
@@ -76,11 +309,49 @@ namespace dae
 		enum class RenderMode { ObservedArea, Diffuse, Specular, Combined };
 		RenderMode m_CurrentRenderMode{ RenderMode::Combined };
 
+		//Pixel shader variant for the render mode, normal map, material mode and mipmap settings, selected once per frame
+		using PixelShader = void (Renderer::*)(const Vertex_Out& v);
+		PixelShader m_PixelShader{ nullptr };
+		bool m_ShaderNeedsUVDerivatives{ true };
+
+		CullMode m_CullMode{ CullMode::Back };
+
+		//Dirty tracking
+		//Set by every setting that changes the image, the camera and meshes track their own changes
+		bool m_IsFrameDirty{ true };
+		uint32_t m_TransformedCameraVersion{ UINT32_MAX };
+
+		//Statistics
+		RenderStatistics m_Statistics{};
+		MeshStatistics m_MeshStatistics{};
+		bool m_MeasurePixelShading{ false };
+
 		//Function that transforms the vertices from the mesh from World space to Screen space
 		void VertexTransformationFunction(std::vector<Mesh>& meshes); //W2 version
+		void BuildVertexStreams(Mesh& mesh);
+		void SelectLod(Mesh& mesh) const;
+		void CullMeshlets(Mesh& mesh, const Matrix& worldViewProjection);
+		void BuildVertexBatches(const Mesh& mesh);
+		bool IsFrameDirty() const;
+		void DeleteMaterial();
 
 		void Render_W3_Part1();
 
+		void BinTriangles();
+		void BinTriangles(const Mesh& mesh, size_t firstIndex, size_t lastIndex);
+		void ClipTriangle(const Mesh& mesh, size_t index, bool shouldSwap);
+		void BinTriangle(const Mesh& mesh, size_t index, bool shouldSwap);
+		bool SetupEdgeFunctions(const Int2& v0, const Int2& v1, const Int2& v2, int64_t area, BinnedTriangle& triangle);
+		void RenderTile(size_t tileIndex);
+		bool RasterizeTriangle(uint32_t triangleIndex, int minX, int minY, int maxX, int maxY, float* pBlockMaxDepths, RenderStatistics& tileStatistics);
+		float GetMaxDepth(int minX, int minY, int maxX, int maxY) const;
+		void ShadeVisibilityBuffer(int minX, int minY, int maxX, int maxY, RenderStatistics& tileStatistics);
+		void ShadeFragment(const BinnedTriangle& triangle, int px, int py, float currentDepth, const Vector3& vertexRatio, RenderStatistics& tileStatistics);
+
+		void SelectPixelShader();
+		template <RenderMode Mode, bool UseNormalMap>
+		static PixelShader GetPixelShader(MaterialMode materialMode, bool useMipmaps);
+		template <RenderMode Mode, bool UseNormalMap, MaterialMode Material, bool UseMipmaps>
 		void PixelShading(const Vertex_Out& v);
 	};
 }
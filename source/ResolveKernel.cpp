@@ -0,0 +1,95 @@
+#include "ResolveKernel.h"
+
+//External includes
+#include "SDL_pixels.h"
+#if defined(_M_X64) || defined(__SSE2__)
+#define RESOLVE_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+//Standard includes
+#include <algorithm>
+
+namespace dae
+{
+	namespace ResolveKernel
+	{
+		PixelFormat GetPixelFormat(const SDL_PixelFormat* pFormat)
+		{
+			PixelFormat format{};
+			format.redShift = pFormat->Rshift;
+			format.greenShift = pFormat->Gshift;
+			format.blueShift = pFormat->Bshift;
+			format.redLoss = pFormat->Rloss;
+			format.greenLoss = pFormat->Gloss;
+			format.blueLoss = pFormat->Bloss;
+			format.alphaMask = pFormat->Amask;
+			return format;
+		}
+
+		ResolveFunction GetResolveFunction(RasterKernel::InstructionSet instructionSet)
+		{
+			switch (instructionSet)
+			{
+			case RasterKernel::InstructionSet::AVX2:
+				return &ResolveAVX2;
+			case RasterKernel::InstructionSet::SSE2:
+				return &ResolveSSE2;
+			default:
+				return &ResolveScalar;
+			}
+		}
+
+		void ResolveScalar(const ResolveInput& input, size_t first, size_t count, const PixelFormat& format, uint32_t* pPixels)
+		{
+			//std::max returns its first argument when the comparison fails, so NaN becomes 0 like _mm_max_ps(value, zero)
+			const auto toChannel{ [](float value) { return static_cast<uint8_t>(std::min(std::max(0.f, value), 255.f)); } };
+
+			for (size_t index{ first }; index < first + count; ++index)
+			{
+				pPixels[index] = PackColor(format,
+					toChannel(input.pRed[index]),
+					toChannel(input.pGreen[index]),
+					toChannel(input.pBlue[index]));
+			}
+		}
+
+		void ResolveSSE2(const ResolveInput& input, size_t first, size_t count, const PixelFormat& format, uint32_t* pPixels)
+		{
+#if defined(RESOLVE_KERNEL_SSE2)
+			const __m128 zero{ _mm_setzero_ps() };
+			const __m128 maxValue{ _mm_set1_ps(255.f) };
+
+			const __m128i redLoss{ _mm_cvtsi32_si128(static_cast<int>(format.redLoss)) };
+			const __m128i greenLoss{ _mm_cvtsi32_si128(static_cast<int>(format.greenLoss)) };
+			const __m128i blueLoss{ _mm_cvtsi32_si128(static_cast<int>(format.blueLoss)) };
+			const __m128i redShift{ _mm_cvtsi32_si128(static_cast<int>(format.redShift)) };
+			const __m128i greenShift{ _mm_cvtsi32_si128(static_cast<int>(format.greenShift)) };
+			const __m128i blueShift{ _mm_cvtsi32_si128(static_cast<int>(format.blueShift)) };
+			const __m128i alphaMask{ _mm_set1_epi32(static_cast<int>(format.alphaMask)) };
+
+			const size_t end{ first + count };
+			size_t index{ first };
+
+			for (; index + 4 <= end; index += 4)
+			{
+				//Clamp and truncate to 0-255
+				const __m128i red{ _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(input.pRed + index), zero), maxValue)) };
+				const __m128i green{ _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(input.pGreen + index), zero), maxValue)) };
+				const __m128i blue{ _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(input.pBlue + index), zero), maxValue)) };
+
+				const __m128i pixels{ _mm_or_si128(_mm_or_si128(
+					_mm_sll_epi32(_mm_srl_epi32(red, redLoss), redShift),
+					_mm_sll_epi32(_mm_srl_epi32(green, greenLoss), greenShift)), _mm_or_si128(
+					_mm_sll_epi32(_mm_srl_epi32(blue, blueLoss), blueShift), alphaMask)) };
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pPixels + index), pixels);
+			}
+
+			ResolveScalar(input, index, end - index, format, pPixels);
+#else
+			ResolveScalar(input, first, count, format, pPixels);
+#endif
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+//Standard includes
+#include <cstddef>
+#include <cstdint>
+
+//Project includes
+#include "RasterKernel.h"
+
+struct SDL_PixelFormat;
+
+namespace dae
+{
+	//Converts shaded float colors to back buffer pixels
+	//Every kernel truncates like static_cast<uint8_t> and packs like SDL_MapRGB, so they all produce the same pixels
+	namespace ResolveKernel
+	{
+		//Where the 8 bit channels go in a 32 bit back buffer pixel, read once from the surface format
+		struct PixelFormat
+		{
+			uint32_t redShift{ 16 };
+			uint32_t greenShift{ 8 };
+			uint32_t blueShift{};
+
+			//Bits dropped from each channel, 0 for 8 bits per channel
+			uint32_t redLoss{};
+			uint32_t greenLoss{};
+			uint32_t blueLoss{};
+
+			//Alpha is always opaque
+			uint32_t alphaMask{};
+		};
+
+		PixelFormat GetPixelFormat(const SDL_PixelFormat* pFormat);
+
+		//SDL_MapRGB without the library call
+		inline uint32_t PackColor(const PixelFormat& format, uint8_t red, uint8_t green, uint8_t blue)
+		{
+			return (red >> format.redLoss) << format.redShift
+				| (green >> format.greenLoss) << format.greenShift
+				| (blue >> format.blueLoss) << format.blueShift
+				| format.alphaMask;
+		}
+
+		struct ResolveInput
+		{
+			//Colors scaled to 0-255, one array per channel
+			const float* pRed{};
+			const float* pGreen{};
+			const float* pBlue{};
+		};
+
+		//Packs the pixels [first, first + count)
+		using ResolveFunction = void(*)(const ResolveInput& input, size_t first, size_t count, const PixelFormat& format, uint32_t* pPixels);
+
+		ResolveFunction GetResolveFunction(RasterKernel::InstructionSet instructionSet);
+
+		void ResolveScalar(const ResolveInput& input, size_t first, size_t count, const PixelFormat& format, uint32_t* pPixels);
+		void ResolveSSE2(const ResolveInput& input, size_t first, size_t count, const PixelFormat& format, uint32_t* pPixels);
+
+		//Compiled separately with AVX2 enabled, only call it when RasterKernel::DetectInstructionSet reports AVX2
+		void ResolveAVX2(const ResolveInput& input, size_t first, size_t count, const PixelFormat& format, uint32_t* pPixels);
+	}
+}
@@ -0,0 +1,51 @@
+//This file is compiled with AVX2 enabled (/arch:AVX2, -mavx2), see RasterKernel::DetectInstructionSet
+#include "ResolveKernel.h"
+
+//External includes
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace dae
+{
+	namespace ResolveKernel
+	{
+		void ResolveAVX2(const ResolveInput& input, size_t first, size_t count, const PixelFormat& format, uint32_t* pPixels)
+		{
+#if defined(__AVX2__)
+			const __m256 zero{ _mm256_setzero_ps() };
+			const __m256 maxValue{ _mm256_set1_ps(255.f) };
+
+			const __m128i redLoss{ _mm_cvtsi32_si128(static_cast<int>(format.redLoss)) };
+			const __m128i greenLoss{ _mm_cvtsi32_si128(static_cast<int>(format.greenLoss)) };
+			const __m128i blueLoss{ _mm_cvtsi32_si128(static_cast<int>(format.blueLoss)) };
+			const __m128i redShift{ _mm_cvtsi32_si128(static_cast<int>(format.redShift)) };
+			const __m128i greenShift{ _mm_cvtsi32_si128(static_cast<int>(format.greenShift)) };
+			const __m128i blueShift{ _mm_cvtsi32_si128(static_cast<int>(format.blueShift)) };
+			const __m256i alphaMask{ _mm256_set1_epi32(static_cast<int>(format.alphaMask)) };
+
+			const size_t end{ first + count };
+			size_t index{ first };
+
+			for (; index + 8 <= end; index += 8)
+			{
+				//Clamp and truncate to 0-255
+				const __m256i red{ _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(input.pRed + index), zero), maxValue)) };
+				const __m256i green{ _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(input.pGreen + index), zero), maxValue)) };
+				const __m256i blue{ _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(input.pBlue + index), zero), maxValue)) };
+
+				const __m256i pixels{ _mm256_or_si256(_mm256_or_si256(
+					_mm256_sll_epi32(_mm256_srl_epi32(red, redLoss), redShift),
+					_mm256_sll_epi32(_mm256_srl_epi32(green, greenLoss), greenShift)), _mm256_or_si256(
+					_mm256_sll_epi32(_mm256_srl_epi32(blue, blueLoss), blueShift), alphaMask)) };
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(pPixels + index), pixels);
+			}
+
+			ResolveScalar(input, index, end - index, format, pPixels);
+#else
+			ResolveScalar(input, first, count, format, pPixels);
+#endif
+		}
+	}
+}
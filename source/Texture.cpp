@@ -1,42 +1,537 @@
 #include "Texture.h"
-#include "Vector2.h"
+#include "Vector3.h"
 #include <SDL_image.h>
+#include <array>
+#include <bit>
+#include <climits>
 
 namespace dae
 {
-	Texture::Texture(SDL_Surface* pSurface) :
-		m_pSurface{ pSurface },
-		m_pSurfacePixels{ (uint32_t*)pSurface->pixels }
+	namespace
 	{
-		m_pRed = new Uint8;
-		m_pGreen = new Uint8;
-		m_pBlue = new Uint8;
+		ColorRGB ToColor(const Texture::Texel& texel)
+		{
+			return { ChannelToFloat[texel.red], ChannelToFloat[texel.green], ChannelToFloat[texel.blue] };
+		}
+
+		void AddTexel(const Texture::Texel& texel, float weight, ColorRGB& color)
+		{
+			color.m_pRed += ChannelToFloat[texel.red] * weight;
+			color.m_pGreen += ChannelToFloat[texel.green] * weight;
+			color.m_pBlue += ChannelToFloat[texel.blue] * weight;
+		}
+
+		//Moves bit i of the low 16 bits to bit 2i
+		uint32_t SpreadBits(uint32_t value)
+		{
+			value &= 0x0000FFFF;
+			value = (value | (value << 8)) & 0x00FF00FF;
+			value = (value | (value << 4)) & 0x0F0F0F0F;
+			value = (value | (value << 2)) & 0x33333333;
+			value = (value | (value << 1)) & 0x55555555;
+			return value;
+		}
+
+		//Expands 5:6:5 to 8 bits per channel by repeating the high bits
+		Texture::Texel Expand565(uint32_t color)
+		{
+			const uint32_t red{ (color >> 11) & 31 };
+			const uint32_t green{ (color >> 5) & 63 };
+			const uint32_t blue{ color & 31 };
+
+			return { static_cast<uint8_t>((red << 3) | (red >> 2)), static_cast<uint8_t>((green << 2) | (green >> 4)), static_cast<uint8_t>((blue << 3) | (blue >> 2)), 255 };
+		}
+
+		uint32_t To565(float red, float green, float blue)
+		{
+			const uint32_t red5{ static_cast<uint32_t>(std::clamp(red, 0.f, 255.f) * 31.f / 255.f + 0.5f) };
+			const uint32_t green6{ static_cast<uint32_t>(std::clamp(green, 0.f, 255.f) * 63.f / 255.f + 0.5f) };
+			const uint32_t blue5{ static_cast<uint32_t>(std::clamp(blue, 0.f, 255.f) * 31.f / 255.f + 0.5f) };
+
+			return (red5 << 11) | (green6 << 5) | blue5;
+		}
+
+		//Palette entry of a BC1 block, color0 > color1 selects 4 colors, otherwise 3 and black
+		Texture::Texel GetBC1Color(uint32_t color0, uint32_t color1, uint32_t index)
+		{
+			const Texture::Texel endpoint0{ Expand565(color0) };
+			const Texture::Texel endpoint1{ Expand565(color1) };
+
+			//Constant divisors, so the blends compile to multiplications
+			switch (index)
+			{
+			case 0:
+				return endpoint0;
+			case 1:
+				return endpoint1;
+			case 2:
+				if (color0 > color1)
+					return { static_cast<uint8_t>((2 * endpoint0.red + endpoint1.red + 1) / 3), static_cast<uint8_t>((2 * endpoint0.green + endpoint1.green + 1) / 3), static_cast<uint8_t>((2 * endpoint0.blue + endpoint1.blue + 1) / 3), 255 };
+				return { static_cast<uint8_t>((endpoint0.red + endpoint1.red + 1) / 2), static_cast<uint8_t>((endpoint0.green + endpoint1.green + 1) / 2), static_cast<uint8_t>((endpoint0.blue + endpoint1.blue + 1) / 2), 255 };
+			default:
+				if (color0 > color1)
+					return { static_cast<uint8_t>((endpoint0.red + 2 * endpoint1.red + 1) / 3), static_cast<uint8_t>((endpoint0.green + 2 * endpoint1.green + 1) / 3), static_cast<uint8_t>((endpoint0.blue + 2 * endpoint1.blue + 1) / 3), 255 };
+				return { 0, 0, 0, 255 };
+			}
+		}
+
+		//Palette entry of a BC4 block, value0 > value1 selects 8 values, otherwise 6 and 0 and 255
+		uint8_t GetBC4Value(uint32_t value0, uint32_t value1, uint32_t index)
+		{
+			if (index == 0)
+				return static_cast<uint8_t>(value0);
+			if (index == 1)
+				return static_cast<uint8_t>(value1);
+			if (value0 > value1)
+				return static_cast<uint8_t>(((8 - index) * value0 + (index - 1) * value1 + 3) / 7);
+			if (index == 6)
+				return 0;
+			if (index == 7)
+				return 255;
+			return static_cast<uint8_t>(((6 - index) * value0 + (index - 1) * value1 + 2) / 5);
+		}
+
+		//Bits 0-15 and 16-31 hold the endpoints, then 2 bits per texel in row order
+		Texture::Texel DecodeBC1(uint64_t block, int texelIndex)
+		{
+			return GetBC1Color(block & 0xFFFF, (block >> 16) & 0xFFFF, (block >> (32 + 2 * texelIndex)) & 3);
+		}
+
+		//Bits 0-7 and 8-15 hold the endpoints, then 3 bits per texel in row order
+		uint8_t DecodeBC4(uint64_t block, int texelIndex)
+		{
+			return GetBC4Value(block & 0xFF, (block >> 8) & 0xFF, (block >> (16 + 3 * texelIndex)) & 7);
+		}
+
+		//Z of a unit normal from its X and Y, all in [0, 255] like the normal map
+		Texture::Texel DecodeNormal(uint8_t x, uint8_t y)
+		{
+			const float normalX{ x / 255.f * 2.f - 1.f };
+			const float normalY{ y / 255.f * 2.f - 1.f };
+			const float normalZ{ std::sqrt(std::max(1.f - normalX * normalX - normalY * normalY, 0.f)) };
+
+			return { x, y, static_cast<uint8_t>((normalZ * 0.5f + 0.5f) * 255.f + 0.5f), 255 };
+		}
+
+		//Endpoints at the extremes of the texels along their principal axis, every texel takes the closest of the 4 palette colors
+		uint64_t EncodeBC1(const std::array<Texture::Texel, 16>& texels)
+		{
+			float mean[3]{};
+			for (const Texture::Texel& texel : texels)
+			{
+				mean[0] += texel.red / 16.f;
+				mean[1] += texel.green / 16.f;
+				mean[2] += texel.blue / 16.f;
+			}
+
+			float covariance[3][3]{};
+			for (const Texture::Texel& texel : texels)
+			{
+				const float offset[3]{ texel.red - mean[0], texel.green - mean[1], texel.blue - mean[2] };
+				for (int row{}; row < 3; ++row)
+				{
+					for (int column{}; column < 3; ++column)
+					{
+						covariance[row][column] += offset[row] * offset[column];
+					}
+				}
+			}
+
+			//Power iteration, starting along the gray axis
+			float axis[3]{ 1.f, 1.f, 1.f };
+			for (int iteration{}; iteration < 8; ++iteration)
+			{
+				const float next[3]
+				{
+					covariance[0][0] * axis[0] + covariance[0][1] * axis[1] + covariance[0][2] * axis[2],
+					covariance[1][0] * axis[0] + covariance[1][1] * axis[1] + covariance[1][2] * axis[2],
+					covariance[2][0] * axis[0] + covariance[2][1] * axis[1] + covariance[2][2] * axis[2]
+				};
+
+				const float length{ std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]) };
+				if (length < FLT_EPSILON)
+					break;
+
+				axis[0] = next[0] / length;
+				axis[1] = next[1] / length;
+				axis[2] = next[2] / length;
+			}
+
+			float minProjection{ FLT_MAX };
+			float maxProjection{ -FLT_MAX };
+			for (const Texture::Texel& texel : texels)
+			{
+				const float projection{ (texel.red - mean[0]) * axis[0] + (texel.green - mean[1]) * axis[1] + (texel.blue - mean[2]) * axis[2] };
+				minProjection = std::min(minProjection, projection);
+				maxProjection = std::max(maxProjection, projection);
+			}
+
+			uint32_t color0{ To565(mean[0] + axis[0] * maxProjection, mean[1] + axis[1] * maxProjection, mean[2] + axis[2] * maxProjection) };
+			uint32_t color1{ To565(mean[0] + axis[0] * minProjection, mean[1] + axis[1] * minProjection, mean[2] + axis[2] * minProjection) };
+			if (color0 < color1)
+				std::swap(color0, color1);
+
+			uint64_t block{ color0 | (static_cast<uint64_t>(color1) << 16) };
+			if (color0 == color1)
+				return block;
+
+			std::array<Texture::Texel, 4> palette{};
+			for (uint32_t index{}; index < palette.size(); ++index)
+			{
+				palette[index] = GetBC1Color(color0, color1, index);
+			}
+
+			for (size_t texelIndex{}; texelIndex < texels.size(); ++texelIndex)
+			{
+				const Texture::Texel& texel{ texels[texelIndex] };
+
+				uint64_t bestIndex{};
+				int bestDistance{ INT_MAX };
+				for (uint32_t index{}; index < palette.size(); ++index)
+				{
+					const int red{ texel.red - palette[index].red };
+					const int green{ texel.green - palette[index].green };
+					const int blue{ texel.blue - palette[index].blue };
+					const int distance{ red * red + green * green + blue * blue };
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = index;
+					}
+				}
+
+				block |= bestIndex << (32 + 2 * texelIndex);
+			}
+
+			return block;
+		}
+
+		//The block's extremes as endpoints, every value takes the closest of the 8 palette values
+		uint64_t EncodeBC4(const std::array<uint8_t, 16>& values)
+		{
+			const auto [pMin, pMax] { std::minmax_element(values.begin(), values.end()) };
+			const uint32_t value0{ *pMax };
+			const uint32_t value1{ *pMin };
+
+			uint64_t block{ value0 | (value1 << 8) };
+			if (value0 == value1)
+				return block;
+
+			for (size_t texelIndex{}; texelIndex < values.size(); ++texelIndex)
+			{
+				uint64_t bestIndex{};
+				int bestDistance{ INT_MAX };
+				for (uint32_t index{}; index < 8; ++index)
+				{
+					const int distance{ std::abs(values[texelIndex] - GetBC4Value(value0, value1, index)) };
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = index;
+					}
+				}
+
+				block |= bestIndex << (16 + 3 * texelIndex);
+			}
+
+			return block;
+		}
 	}
 
-	Texture::~Texture()
+	MipLevel CreateMipLevel(int width, int height, int blockSize, size_t firstBlock, TextureLayout layout)
 	{
-		if (m_pSurface)
+		const int nrBlocksX{ (width + blockSize - 1) / blockSize };
+		const int nrBlocksY{ (height + blockSize - 1) / blockSize };
+
+		MipLevel level{ width, height };
+		level.offsetsX.resize(nrBlocksX);
+		level.offsetsY.resize(nrBlocksY);
+
+		if (layout == TextureLayout::Linear)
 		{
-			SDL_FreeSurface(m_pSurface);
-			m_pSurface = nullptr;
+			level.nrBlocks = static_cast<size_t>(nrBlocksX) * nrBlocksY;
+			for (int x{}; x < nrBlocksX; ++x)
+			{
+				level.offsetsX[x] = static_cast<uint32_t>(x);
+			}
+			for (int y{}; y < nrBlocksY; ++y)
+			{
+				level.offsetsY[y] = static_cast<uint32_t>(firstBlock + static_cast<size_t>(y) * nrBlocksX);
+			}
+
+			return level;
+		}
+
+		//x takes the even bits and y the odd ones, up to the bit count of the shorter side
+		//The longer side's remaining bits sit above those and pick one of the square blocks it is made of
+		const uint32_t paddedWidth{ std::bit_ceil(static_cast<uint32_t>(nrBlocksX)) };
+		const uint32_t paddedHeight{ std::bit_ceil(static_cast<uint32_t>(nrBlocksY)) };
+		const int nrSharedBits{ std::countr_zero(std::min(paddedWidth, paddedHeight)) };
+		const uint32_t sharedMask{ (1u << nrSharedBits) - 1 };
+
+		level.nrBlocks = static_cast<size_t>(paddedWidth) * paddedHeight;
+		for (int x{}; x < nrBlocksX; ++x)
+		{
+			level.offsetsX[x] = SpreadBits(x & sharedMask) | ((x >> nrSharedBits) << (2 * nrSharedBits));
+		}
+		for (int y{}; y < nrBlocksY; ++y)
+		{
+			level.offsetsY[y] = static_cast<uint32_t>(firstBlock) + ((SpreadBits(y & sharedMask) << 1) | ((y >> nrSharedBits) << (2 * nrSharedBits)));
 		}
 
-		delete m_pRed;
-		delete m_pGreen;
-		delete m_pBlue;
+		return level;
 	}
 
-	Texture* Texture::LoadFromFile(const std::string& path)
+	Texture::Texture(SDL_Surface* pConverted, TextureLayout layout)
+		: m_Layout{ layout }
 	{
-		return new Texture(IMG_Load(path.c_str()));
+		AddMipLevel(pConverted->w, pConverted->h);
+
+		for (int y{}; y < pConverted->h; ++y)
+		{
+			const Texel* pRow{ reinterpret_cast<const Texel*>(static_cast<const uint8_t*>(pConverted->pixels) + static_cast<size_t>(y) * pConverted->pitch) };
+			for (int x{}; x < pConverted->w; ++x)
+			{
+				m_Texels[m_Levels[0].GetBlockIndex(x, y)] = pRow[x];
+			}
+		}
+
+		SDL_FreeSurface(pConverted);
+
+		GenerateMipLevels();
+	}
+
+	Texture::Texture(TextureFormat format, TextureLayout layout)
+		: m_Format{ format }
+		, m_Layout{ layout }
+	{
+	}
+
+	Texture* Texture::LoadFromFile(const std::string& path, TextureLayout layout)
+	{
+		SDL_Surface* pSurface{ IMG_Load(path.c_str()) };
+		if (!pSurface)
+			return nullptr;
+
+		//Decode once into RGBA8, sampling no longer goes through the surface's pixel format
+		SDL_Surface* pConverted{ SDL_ConvertSurfaceFormat(pSurface, SDL_PIXELFORMAT_RGBA32, 0) };
+		SDL_FreeSurface(pSurface);
+		if (!pConverted)
+			return nullptr;
+
+		return new Texture(pConverted, layout);
+	}
+
+	Texture* Texture::CreateSolid(int width, int height, const Texel& texel, TextureLayout layout)
+	{
+		Texture* pTexture{ new Texture(TextureFormat::RGBA8, layout) };
+		pTexture->AddMipLevel(width, height);
+		std::fill(pTexture->m_Texels.begin(), pTexture->m_Texels.end(), texel);
+		pTexture->GenerateMipLevels();
+		return pTexture;
+	}
+
+	Texture* Texture::CreateCompressed(const Texture& source, TextureFormat format)
+	{
+		if (source.m_Format != TextureFormat::RGBA8 || format == TextureFormat::RGBA8)
+			return nullptr;
+
+		Texture* pTexture{ new Texture(format, source.m_Layout) };
+		const size_t wordsPerBlock{ format == TextureFormat::BC5 ? 2u : 1u };
+
+		for (size_t levelIndex{}; levelIndex < source.GetNrLevels(); ++levelIndex)
+		{
+			const MipLevel& sourceLevel{ source.GetLevel(levelIndex) };
+			pTexture->m_Levels.push_back(CreateMipLevel(sourceLevel.width, sourceLevel.height, 4, pTexture->m_Blocks.size() / wordsPerBlock, source.m_Layout));
+			pTexture->m_Blocks.resize(pTexture->m_Blocks.size() + pTexture->m_Levels.back().nrBlocks * wordsPerBlock);
+
+			const MipLevel& level{ pTexture->m_Levels.back() };
+			for (int blockY{}; blockY < static_cast<int>(level.offsetsY.size()); ++blockY)
+			{
+				for (int blockX{}; blockX < static_cast<int>(level.offsetsX.size()); ++blockX)
+				{
+					//Levels smaller than a block repeat their last row and column
+					std::array<Texel, 16> texels{};
+					for (int texelIndex{}; texelIndex < 16; ++texelIndex)
+					{
+						const int x{ std::min(blockX * 4 + texelIndex % 4, level.width - 1) };
+						const int y{ std::min(blockY * 4 + texelIndex / 4, level.height - 1) };
+						texels[texelIndex] = source.GetTexel(levelIndex, x, y);
+					}
+
+					uint64_t* pBlock{ &pTexture->m_Blocks[level.GetBlockIndex(blockX, blockY) * wordsPerBlock] };
+					switch (format)
+					{
+					case TextureFormat::BC1:
+						pBlock[0] = EncodeBC1(texels);
+						break;
+					case TextureFormat::BC4:
+					{
+						std::array<uint8_t, 16> values{};
+						for (int texelIndex{}; texelIndex < 16; ++texelIndex)
+						{
+							values[texelIndex] = texels[texelIndex].red;
+						}
+						pBlock[0] = EncodeBC4(values);
+						break;
+					}
+					default:
+					{
+						//Shading only uses the normal's direction, so storing it at unit length keeps it exact while Z is rebuilt
+						std::array<uint8_t, 16> valuesX{};
+						std::array<uint8_t, 16> valuesY{};
+						for (int texelIndex{}; texelIndex < 16; ++texelIndex)
+						{
+							Vector3 normal{ texels[texelIndex].red / 255.f * 2.f - 1.f, texels[texelIndex].green / 255.f * 2.f - 1.f, texels[texelIndex].blue / 255.f * 2.f - 1.f };
+							normal = normal.SqrMagnitude() > 0.f ? normal.Normalized() : Vector3::UnitZ;
+
+							valuesX[texelIndex] = static_cast<uint8_t>((normal.x * 0.5f + 0.5f) * 255.f + 0.5f);
+							valuesY[texelIndex] = static_cast<uint8_t>((normal.y * 0.5f + 0.5f) * 255.f + 0.5f);
+						}
+						pBlock[0] = EncodeBC4(valuesX);
+						pBlock[1] = EncodeBC4(valuesY);
+						break;
+					}
+					}
+				}
+			}
+		}
+
+		return pTexture;
+	}
+
+	Texture::Texel Texture::GetTexel(size_t level, int x, int y) const
+	{
+		switch (m_Format)
+		{
+		case TextureFormat::BC1:
+			return GetTexel<TextureFormat::BC1>(level, x, y);
+		case TextureFormat::BC4:
+			return GetTexel<TextureFormat::BC4>(level, x, y);
+		case TextureFormat::BC5:
+			return GetTexel<TextureFormat::BC5>(level, x, y);
+		default:
+			return GetTexel<TextureFormat::RGBA8>(level, x, y);
+		}
+	}
+
+	template <TextureFormat Format>
+	Texture::Texel Texture::GetTexel(size_t level, int x, int y) const
+	{
+		const MipLevel& mipLevel{ m_Levels[level] };
+		if constexpr (Format == TextureFormat::RGBA8)
+		{
+			return m_Texels[mipLevel.GetBlockIndex(x, y)];
+		}
+		else
+		{
+			const size_t blockIndex{ mipLevel.GetBlockIndex(x >> 2, y >> 2) };
+			const int texelIndex{ (x & 3) + (y & 3) * 4 };
+
+			if constexpr (Format == TextureFormat::BC1)
+			{
+				return DecodeBC1(m_Blocks[blockIndex], texelIndex);
+			}
+			else if constexpr (Format == TextureFormat::BC4)
+			{
+				const uint8_t value{ DecodeBC4(m_Blocks[blockIndex], texelIndex) };
+				return { value, value, value, 255 };
+			}
+			else
+			{
+				return DecodeNormal(DecodeBC4(m_Blocks[blockIndex * 2], texelIndex), DecodeBC4(m_Blocks[blockIndex * 2 + 1], texelIndex));
+			}
+		}
+	}
+
+	void Texture::AddMipLevel(int width, int height)
+	{
+		m_Levels.push_back(CreateMipLevel(width, height, 1, m_Texels.size(), m_Layout));
+		m_Texels.resize(m_Texels.size() + m_Levels.back().nrBlocks);
+	}
+
+	void Texture::GenerateMipLevels()
+	{
+		while (m_Levels.back().width > 1 || m_Levels.back().height > 1)
+		{
+			const size_t sourceIndex{ m_Levels.size() - 1 };
+			AddMipLevel(std::max(m_Levels[sourceIndex].width / 2, 1), std::max(m_Levels[sourceIndex].height / 2, 1));
+
+			const MipLevel& source{ m_Levels[sourceIndex] };
+			const MipLevel& level{ m_Levels.back() };
+
+			//Box filter over the 2x2 texels below, an odd last row or column is read twice
+			for (int y{}; y < level.height; ++y)
+			{
+				const int y0{ std::min(2 * y, source.height - 1) };
+				const int y1{ std::min(2 * y + 1, source.height - 1) };
+
+				for (int x{}; x < level.width; ++x)
+				{
+					const int x0{ std::min(2 * x, source.width - 1) };
+					const int x1{ std::min(2 * x + 1, source.width - 1) };
+
+					const Texel& texel00{ m_Texels[source.GetBlockIndex(x0, y0)] };
+					const Texel& texel10{ m_Texels[source.GetBlockIndex(x1, y0)] };
+					const Texel& texel01{ m_Texels[source.GetBlockIndex(x0, y1)] };
+					const Texel& texel11{ m_Texels[source.GetBlockIndex(x1, y1)] };
+
+					Texel& texel{ m_Texels[level.GetBlockIndex(x, y)] };
+					texel.red = static_cast<uint8_t>((texel00.red + texel10.red + texel01.red + texel11.red + 2) / 4);
+					texel.green = static_cast<uint8_t>((texel00.green + texel10.green + texel01.green + texel11.green + 2) / 4);
+					texel.blue = static_cast<uint8_t>((texel00.blue + texel10.blue + texel01.blue + texel11.blue + 2) / 4);
+					texel.alpha = static_cast<uint8_t>((texel00.alpha + texel10.alpha + texel01.alpha + texel11.alpha + 2) / 4);
+				}
+			}
+		}
 	}
 
 	ColorRGB Texture::Sample(const Vector2& uv) const
 	{
 		//Sample the correct texel for the given uv
+		const MipLevel& level{ m_Levels[0] };
+		return ToColor(GetTexel(0, GetNearestTexel(uv.x, level.width), GetNearestTexel(uv.y, level.height)));
+	}
+
+	ColorRGB Texture::Sample(const Vector2& uv, const Vector2& uvDerivativeX, const Vector2& uvDerivativeY) const
+	{
+		//One switch per sample instead of per texel
+		switch (m_Format)
+		{
+		case TextureFormat::BC1:
+			return SampleTrilinear<TextureFormat::BC1>(uv, uvDerivativeX, uvDerivativeY);
+		case TextureFormat::BC4:
+			return SampleTrilinear<TextureFormat::BC4>(uv, uvDerivativeX, uvDerivativeY);
+		case TextureFormat::BC5:
+			return SampleTrilinear<TextureFormat::BC5>(uv, uvDerivativeX, uvDerivativeY);
+		default:
+			return SampleTrilinear<TextureFormat::RGBA8>(uv, uvDerivativeX, uvDerivativeY);
+		}
+	}
+
+	template <TextureFormat Format>
+	ColorRGB Texture::SampleTrilinear(const Vector2& uv, const Vector2& uvDerivativeX, const Vector2& uvDerivativeY) const
+	{
+		const float level{ std::min(GetMipLevel(uvDerivativeX, uvDerivativeY, m_Levels[0].width, m_Levels[0].height), static_cast<float>(m_Levels.size() - 1)) };
+		const size_t level0{ static_cast<size_t>(level) };
+		const float fraction{ level - level0 };
 
-		SDL_GetRGB(m_pSurfacePixels[static_cast<Uint32>(int(uv.x * m_pSurface->w) + int(uv.y * m_pSurface->h) * m_pSurface->w)], m_pSurface->format, m_pRed, m_pGreen, m_pBlue);
+		ColorRGB color{};
+		AddBilinear<Format>(uv, level0, 1.f - fraction, color);
+		if (fraction > 0.f)
+			AddBilinear<Format>(uv, level0 + 1, fraction, color);
+
+		return color;
+	}
+
+	template <TextureFormat Format>
+	void Texture::AddBilinear(const Vector2& uv, size_t level, float levelWeight, ColorRGB& color) const
+	{
+		const BilinearFootprint footprint{ GetBilinearFootprint(uv, m_Levels[level].width, m_Levels[level].height, levelWeight) };
 
-		return { *m_pRed / 255.f, *m_pGreen / 255.f, *m_pBlue / 255.f };
+		AddTexel(GetTexel<Format>(level, footprint.x0, footprint.y0), footprint.weight00, color);
+		AddTexel(GetTexel<Format>(level, footprint.x1, footprint.y0), footprint.weight10, color);
+		AddTexel(GetTexel<Format>(level, footprint.x0, footprint.y1), footprint.weight01, color);
+		AddTexel(GetTexel<Format>(level, footprint.x1, footprint.y1), footprint.weight11, color);
 	}
-}
\ No newline at end of file
+}
@@ -1,26 +1,173 @@
 #pragma once
 #include <SDL_surface.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <string>
+#include <vector>
 #include "ColorRGB.h"
+#include "Vector2.h"
 
 namespace dae
 {
-	struct Vector2;
+	//Channel value / 255, the same division SDL_GetRGB users did per sample
+	inline constexpr std::array<float, 256> ChannelToFloat{ []
+		{
+			std::array<float, 256> values{};
+			for (size_t value{}; value < values.size(); ++value)
+			{
+				values[value] = value / 255.f;
+			}
+
+			return values;
+		}() };
+
+	//Order of the texels of one mip level in memory
+	//Morton (Z-order) interleaves the bits of x and y, so texels that are close in any direction are close in memory
+	//and a triangle that runs at an angle in UV space touches as few cache lines as one along a row
+	enum class TextureLayout { Linear, Morton };
+
+	//How texels are stored, the block compressed formats keep 4x4 texels in 8 or 16 bytes and are decoded per texel when sampled
+	//BC1: RGB with two 5:6:5 endpoints and 2 bit indices, 4 bits per texel
+	//BC4: one channel with two 8 bit endpoints and 3 bit indices, 4 bits per texel, sampled as gray
+	//BC5: two BC4 channels holding the X and Y of a unit normal, Z is rebuilt when decoding, 8 bits per texel
+	enum class TextureFormat { RGBA8, BC1, BC4, BC5 };
+
+	//One image of a mip chain, the levels of a chain share one block array
+	//A block's index in that array is offsetsX[blockX] + offsetsY[blockY], the sampler does not need to know the layout
+	//Uncompressed levels use one texel per block
+	struct MipLevel
+	{
+		int width{};
+		int height{};
+		size_t nrBlocks{}; //Morton pads both sides to a power of two
+
+		std::vector<uint32_t> offsetsX{};
+		std::vector<uint32_t> offsetsY{};
+
+		size_t GetBlockIndex(int blockX, int blockY) const { return static_cast<size_t>(offsetsX[blockX]) + offsetsY[blockY]; }
+	};
+
+	//Offset tables of a level of blockSize x blockSize blocks, whose blocks start at firstBlock
+	MipLevel CreateMipLevel(int width, int height, int blockSize, size_t firstBlock, TextureLayout layout);
+
+	//Mip level whose texels lie about one pixel apart, from the screen space UV derivatives and the size of level 0
+	//Never below 0, magnified textures read level 0
+	inline float GetMipLevel(const Vector2& uvDerivativeX, const Vector2& uvDerivativeY, int width, int height)
+	{
+		const float lengthSquaredX{ Square(uvDerivativeX.x * width) + Square(uvDerivativeX.y * height) };
+		const float lengthSquaredY{ Square(uvDerivativeY.x * width) + Square(uvDerivativeY.y * height) };
+
+		return 0.5f * std::log2(std::max(std::max(lengthSquaredX, lengthSquaredY), 1.f));
+	}
+
+	//Texel column or row under a uv coordinate for nearest sampling, clamped to the level like the bilinear footprint
+	//Clamped before the conversion, so uv outside [0, 1) can neither overflow the int nor index past the level's offset tables
+	inline int GetNearestTexel(float coordinate, int size)
+	{
+		return static_cast<int>(std::clamp(coordinate * size, 0.f, static_cast<float>(size - 1)));
+	}
+
+	//The 2x2 texels around uv in one mip level and their bilinear weights, scaled by the weight of the level
+	struct BilinearFootprint
+	{
+		int x0{};
+		int y0{};
+		int x1{};
+		int y1{};
+		float weight00{};
+		float weight10{};
+		float weight01{};
+		float weight11{};
+	};
+
+	//Texel centers sit half a texel in, addresses outside the level are clamped to its edge
+	inline BilinearFootprint GetBilinearFootprint(const Vector2& uv, int width, int height, float levelWeight)
+	{
+		const float x{ uv.x * width - 0.5f };
+		const float y{ uv.y * height - 0.5f };
+		const float floorX{ std::floor(x) };
+		const float floorY{ std::floor(y) };
+		const float fractionX{ x - floorX };
+		const float fractionY{ y - floorY };
+
+		const int x0{ static_cast<int>(floorX) };
+		const int y0{ static_cast<int>(floorY) };
+
+		return
+		{
+			std::clamp(x0, 0, width - 1),
+			std::clamp(y0, 0, height - 1),
+			std::clamp(x0 + 1, 0, width - 1),
+			std::clamp(y0 + 1, 0, height - 1),
+			(1.f - fractionX) * (1.f - fractionY) * levelWeight,
+			fractionX * (1.f - fractionY) * levelWeight,
+			(1.f - fractionX) * fractionY * levelWeight,
+			fractionX * fractionY * levelWeight
+		};
+	}
 
 	class Texture
 	{
 	public:
-		~Texture();
+		~Texture() = default;
+
+		static Texture* LoadFromFile(const std::string& path, TextureLayout layout = TextureLayout::Morton);
+
+		//Encodes every mip level of an RGBA8 texture, BC5 expects a tangent space normal map
+		static Texture* CreateCompressed(const Texture& source, TextureFormat format);
 
-		static Texture* LoadFromFile(const std::string& path);
+		//Reads only the stored texels, so any number of threads can sample at once
+		//Nearest texel of level 0
 		ColorRGB Sample(const Vector2& uv) const;
 
+		//Trilinear: the 2x2 texels around uv in the two mip levels around the one picked by the UV derivatives, weighted by distance
+		ColorRGB Sample(const Vector2& uv, const Vector2& uvDerivativeX, const Vector2& uvDerivativeY) const;
+
+		//8 bits per channel in memory order, whatever format the image was loaded in
+		struct alignas(4) Texel
+		{
+			uint8_t red{};
+			uint8_t green{};
+			uint8_t blue{};
+			uint8_t alpha{};
+		};
+
+		//Every texel of every level set to texel, stands in for a map a material does not have
+		static Texture* CreateSolid(int width, int height, const Texel& texel, TextureLayout layout = TextureLayout::Morton);
+
+		TextureFormat GetFormat() const { return m_Format; }
+		size_t GetNrLevels() const { return m_Levels.size(); }
+		const MipLevel& GetLevel(size_t level) const { return m_Levels[level]; }
+
+		//Decodes the texel when the texture is compressed
+		Texel GetTexel(size_t level, int x, int y) const;
+
+		//Texel or block storage of all levels, in bytes
+		size_t GetMemorySize() const { return m_Texels.size() * sizeof(Texel) + m_Blocks.size() * sizeof(uint64_t); }
+
 	private:
-		Uint8 *m_pRed, * m_pGreen, * m_pBlue;
+		//Takes ownership of an RGBA32 surface
+		Texture(SDL_Surface* pConverted, TextureLayout layout);
+		Texture(TextureFormat format, TextureLayout layout);
+
+		void AddMipLevel(int width, int height);
+		void GenerateMipLevels();
+		template <TextureFormat Format>
+		Texel GetTexel(size_t level, int x, int y) const;
+		template <TextureFormat Format>
+		ColorRGB SampleTrilinear(const Vector2& uv, const Vector2& uvDerivativeX, const Vector2& uvDerivativeY) const;
+		template <TextureFormat Format>
+		void AddBilinear(const Vector2& uv, size_t level, float levelWeight, ColorRGB& color) const;
 
-		Texture(SDL_Surface* pSurface);
+		//Level 0 is the loaded image, every next level halves it down to 1x1
+		TextureFormat m_Format{ TextureFormat::RGBA8 };
+		TextureLayout m_Layout{};
+		std::vector<MipLevel> m_Levels{};
+		std::vector<Texel> m_Texels{};
 
-		SDL_Surface* m_pSurface{ nullptr };
-		uint32_t* m_pSurfacePixels{ nullptr };
+		//Blocks of the compressed formats, BC5 stores its X and Y block next to each other
+		std::vector<uint64_t> m_Blocks{};
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,101 @@
+#include "ThreadPool.h"
+
+//Standard includes
+#include <algorithm>
+
+using namespace dae;
+
+ThreadPool::ThreadPool(size_t nrThreads)
+{
+	if (nrThreads == 0)
+	{
+		nrThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	//The calling thread is the last worker
+	m_Workers.reserve(nrThreads - 1);
+	for (size_t index{ 1 }; index < nrThreads; ++index)
+	{
+		m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_IsShuttingDown = true;
+	}
+	m_WorkAvailable.notify_all();
+
+	for (std::thread& worker : m_Workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& job)
+{
+	if (count == 0)
+		return;
+
+	if (m_Workers.empty() || count == 1)
+	{
+		for (size_t index{}; index < count; ++index)
+		{
+			job(index);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_pJob = &job;
+		m_JobCount = count;
+		m_NextJob = 0;
+		m_NrBusyWorkers = m_Workers.size();
+		++m_Generation;
+	}
+	m_WorkAvailable.notify_all();
+
+	RunJobs();
+
+	//Wait until every worker left RunJobs, so the job can safely go out of scope
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	m_WorkFinished.wait(lock, [this]() { return m_NrBusyWorkers == 0; });
+	m_pJob = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	uint64_t lastGeneration{};
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock{ m_Mutex };
+			m_WorkAvailable.wait(lock, [this, lastGeneration]() { return m_IsShuttingDown || m_Generation != lastGeneration; });
+
+			if (m_IsShuttingDown)
+				return;
+
+			lastGeneration = m_Generation;
+		}
+
+		RunJobs();
+
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			--m_NrBusyWorkers;
+		}
+		m_WorkFinished.notify_one();
+	}
+}
+
+void ThreadPool::RunJobs()
+{
+	for (size_t index{ m_NextJob++ }; index < m_JobCount; index = m_NextJob++)
+	{
+		(*m_pJob)(index);
+	}
+}
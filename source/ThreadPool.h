@@ -0,0 +1,51 @@
+#pragma once
+
+//Standard includes
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dae
+{
+	//Persistent worker threads that split index ranges between them
+	class ThreadPool final
+	{
+	public:
+		//0 uses one thread per hardware core
+		ThreadPool(size_t nrThreads = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) noexcept = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+
+		//Calls job(index) for every index in [0, count) and returns when all of them finished
+		//The calling thread helps, so a pool of 1 thread runs everything on the caller
+		void ParallelFor(size_t count, const std::function<void(size_t)>& job);
+
+		size_t GetThreadCount() const { return m_Workers.size() + 1; }
+
+	private:
+		void WorkerLoop();
+		void RunJobs();
+
+		std::vector<std::thread> m_Workers{};
+
+		std::mutex m_Mutex{};
+		std::condition_variable m_WorkAvailable{};
+		std::condition_variable m_WorkFinished{};
+
+		const std::function<void(size_t)>* m_pJob{ nullptr };
+		size_t m_JobCount{};
+		std::atomic<size_t> m_NextJob{};
+
+		uint64_t m_Generation{};
+		size_t m_NrBusyWorkers{};
+		bool m_IsShuttingDown{ false };
+	};
+}
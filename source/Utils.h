@@ -1,6 +1,7 @@
 #pragma once
 #include <cassert>
 #include <fstream>
+#include <unordered_map>
 #include "Math.h"
 #include "DataTypes.h"
 
@@ -35,6 +36,24 @@ namespace dae
 			return true;
 		}
 
+		//OBJ indices of one face corner, corners with the same indices share one vertex
+		struct ObjVertexKey
+		{
+			size_t position{};
+			size_t texCoord{};
+			size_t normal{};
+
+			bool operator==(const ObjVertexKey& other) const = default;
+		};
+
+		struct ObjVertexKeyHash
+		{
+			size_t operator()(const ObjVertexKey& key) const
+			{
+				return key.position * 73856093u ^ key.texCoord * 19349663u ^ key.normal * 83492791u;
+			}
+		};
+
 		//Just parses vertices and indices
 #pragma warning(push)
 #pragma warning(disable : 4505) //Warning unreferenced local function
@@ -59,6 +78,9 @@ namespace dae
 			vertices.clear();
 			indices.clear();
 
+			//Index of the vertex every distinct position/uv/normal combination became
+			std::unordered_map<ObjVertexKey, uint32_t, ObjVertexKeyHash> vertexIndices{};
+
 			std::string sCommand;
 			// start a while iteration ending when the end of file is reached (ios::eof)
 			while (!file.eof())
@@ -102,7 +124,7 @@ namespace dae
 					//
 					// Faces or triangles
 					Vertex vertex{};
-					size_t iPosition, iTexCoord, iNormal;
+					size_t iPosition{}, iTexCoord{}, iNormal{};
 
 					uint32_t tempIndices[3];
 					for (size_t iFace = 0; iFace < 3; iFace++)
@@ -132,9 +154,12 @@ namespace dae
 							}
 						}
 
-						vertices.push_back(vertex);
-						tempIndices[iFace] = uint32_t(vertices.size()) - 1;
-						//indices.push_back(uint32_t(vertices.size()) - 1);
+						//Only the first corner with these indices adds a vertex
+						const auto [vertexIndex, isNewVertex] = vertexIndices.try_emplace({ iPosition, iTexCoord, iNormal }, uint32_t(vertices.size()));
+						if (isNewVertex)
+							vertices.push_back(vertex);
+
+						tempIndices[iFace] = vertexIndex->second;
 					}
 
 					indices.push_back(tempIndices[0]);
@@ -171,7 +196,11 @@ namespace dae
 				const Vector3 edge1 = p2 - p0;
 				const Vector2 diffX = Vector2(uv1.x - uv0.x, uv2.x - uv0.x);
 				const Vector2 diffY = Vector2(uv1.y - uv0.y, uv2.y - uv0.y);
-				float r = 1.f / Vector2::Cross(diffX, diffY);
+
+				//Triangles without uv area have no tangent direction, they would add infinities
+				const float uvArea = Vector2::Cross(diffX, diffY);
+				if (std::abs(uvArea) < 1e-12f) continue;
+				float r = 1.f / uvArea;
 
 				Vector3 tangent = (edge0 * diffY.y - edge1 * diffY.x) * r;
 				vertices[index0].tangent += tangent;
@@ -182,7 +211,15 @@ namespace dae
 			//Fix the tangents per vertex now because we accumulated
 			for (auto& v : vertices)
 			{
-				v.tangent = Vector3::Reject(v.tangent, v.normal).Normalized();
+				v.tangent = Vector3::Reject(v.tangent, v.normal);
+
+				//Nothing accumulated or only along the normal, any direction orthogonal to the normal will do
+				if (v.tangent.SqrMagnitude() < 1e-12f)
+				{
+					const Vector3& axis = std::abs(v.normal.x) < 0.9f ? Vector3::UnitX : Vector3::UnitY;
+					v.tangent = Vector3::Cross(v.normal, axis);
+				}
+				v.tangent.Normalize();
 
 				if(flipAxisAndWinding)
 				{
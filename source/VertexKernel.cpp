@@ -0,0 +1,166 @@
+#include "VertexKernel.h"
+
+//External includes
+#if defined(_M_X64) || defined(__SSE2__)
+#define VERTEX_KERNEL_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace dae
+{
+	namespace VertexKernel
+	{
+#if defined(VERTEX_KERNEL_SSE2)
+		namespace
+		{
+			//Matrix::TransformPoint for one output component: m0 * x + m1 * y + m2 * z + m3
+			__m128 TransformPoint(__m128 x, __m128 y, __m128 z, float m0, float m1, float m2, float m3)
+			{
+				return _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m0), x), _mm_mul_ps(_mm_set1_ps(m1), y)), _mm_mul_ps(_mm_set1_ps(m2), z)), _mm_set1_ps(m3));
+			}
+
+			//Matrix::TransformVector for one output component: m0 * x + m1 * y + m2 * z
+			__m128 TransformVector(__m128 x, __m128 y, __m128 z, float m0, float m1, float m2)
+			{
+				return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m0), x), _mm_mul_ps(_mm_set1_ps(m1), y)), _mm_mul_ps(_mm_set1_ps(m2), z));
+			}
+
+			//Vector3::Normalized
+			void Normalize(__m128& x, __m128& y, __m128& z)
+			{
+				const __m128 magnitude{ _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z))) };
+				x = _mm_div_ps(x, magnitude);
+				y = _mm_div_ps(y, magnitude);
+				z = _mm_div_ps(z, magnitude);
+			}
+		}
+#endif
+
+		TransformFunction GetTransformFunction(RasterKernel::InstructionSet instructionSet)
+		{
+			switch (instructionSet)
+			{
+			case RasterKernel::InstructionSet::AVX2:
+				return &TransformAVX2;
+			case RasterKernel::InstructionSet::SSE2:
+				return &TransformSSE2;
+			default:
+				return &TransformScalar;
+			}
+		}
+
+		void TransformScalar(const TransformInput& input, size_t first, size_t count, const TransformOutput& output)
+		{
+			for (size_t index{ first }; index < first + count; ++index)
+			{
+				const Vector4 positionClip{ input.worldViewProjection.TransformPoint(input.pPositionX[index], input.pPositionY[index], input.pPositionZ[index], 0.f) };
+				output.pPositionsClip[index] = positionClip;
+
+				//Perspective divide and NDC -> raster space
+				const float inverseW{ 1.f / positionClip.w };
+				output.pPositionsOut[index] =
+				{
+					0.5f * (positionClip.x * inverseW + 1.f) * input.width,
+					0.5f * (1.f - positionClip.y * inverseW) * input.height,
+					positionClip.z * inverseW,
+					inverseW
+				};
+
+				output.pNormals[index] = input.world.TransformVector(input.pNormalX[index], input.pNormalY[index], input.pNormalZ[index]).Normalized();
+				output.pTangents[index] = input.world.TransformVector(input.pTangentX[index], input.pTangentY[index], input.pTangentZ[index]).Normalized();
+
+				output.pViewDirections[index] = input.world.TransformPoint(input.pPositionX[index], input.pPositionY[index], input.pPositionZ[index]) - input.cameraOrigin;
+			}
+		}
+
+		void TransformSSE2(const TransformInput& input, size_t first, size_t count, const TransformOutput& output)
+		{
+#if defined(VERTEX_KERNEL_SSE2)
+			const Matrix& worldViewProjection{ input.worldViewProjection };
+			const Matrix& world{ input.world };
+
+			const __m128 half{ _mm_set1_ps(0.5f) };
+			const __m128 one{ _mm_set1_ps(1.f) };
+
+			const size_t end{ first + count };
+			size_t index{ first };
+
+			for (; index + 4 <= end; index += 4)
+			{
+				const __m128 positionX{ _mm_loadu_ps(input.pPositionX + index) };
+				const __m128 positionY{ _mm_loadu_ps(input.pPositionY + index) };
+				const __m128 positionZ{ _mm_loadu_ps(input.pPositionZ + index) };
+
+				//World view projection
+				const __m128 clipX{ TransformPoint(positionX, positionY, positionZ, worldViewProjection[0].x, worldViewProjection[1].x, worldViewProjection[2].x, worldViewProjection[3].x) };
+				const __m128 clipY{ TransformPoint(positionX, positionY, positionZ, worldViewProjection[0].y, worldViewProjection[1].y, worldViewProjection[2].y, worldViewProjection[3].y) };
+				const __m128 clipZ{ TransformPoint(positionX, positionY, positionZ, worldViewProjection[0].z, worldViewProjection[1].z, worldViewProjection[2].z, worldViewProjection[3].z) };
+				const __m128 clipW{ TransformPoint(positionX, positionY, positionZ, worldViewProjection[0].w, worldViewProjection[1].w, worldViewProjection[2].w, worldViewProjection[3].w) };
+
+				//Perspective divide and NDC -> raster space
+				const __m128 inverseW{ _mm_div_ps(one, clipW) };
+				const __m128 rasterX{ _mm_mul_ps(_mm_mul_ps(half, _mm_add_ps(_mm_mul_ps(clipX, inverseW), one)), _mm_set1_ps(input.width)) };
+				const __m128 rasterY{ _mm_mul_ps(_mm_mul_ps(half, _mm_sub_ps(one, _mm_mul_ps(clipY, inverseW))), _mm_set1_ps(input.height)) };
+				const __m128 depth{ _mm_mul_ps(clipZ, inverseW) };
+
+				//Normals and tangents to world space
+				const __m128 objectNormalX{ _mm_loadu_ps(input.pNormalX + index) };
+				const __m128 objectNormalY{ _mm_loadu_ps(input.pNormalY + index) };
+				const __m128 objectNormalZ{ _mm_loadu_ps(input.pNormalZ + index) };
+
+				__m128 normalX{ TransformVector(objectNormalX, objectNormalY, objectNormalZ, world[0].x, world[1].x, world[2].x) };
+				__m128 normalY{ TransformVector(objectNormalX, objectNormalY, objectNormalZ, world[0].y, world[1].y, world[2].y) };
+				__m128 normalZ{ TransformVector(objectNormalX, objectNormalY, objectNormalZ, world[0].z, world[1].z, world[2].z) };
+				Normalize(normalX, normalY, normalZ);
+
+				const __m128 objectTangentX{ _mm_loadu_ps(input.pTangentX + index) };
+				const __m128 objectTangentY{ _mm_loadu_ps(input.pTangentY + index) };
+				const __m128 objectTangentZ{ _mm_loadu_ps(input.pTangentZ + index) };
+
+				__m128 tangentX{ TransformVector(objectTangentX, objectTangentY, objectTangentZ, world[0].x, world[1].x, world[2].x) };
+				__m128 tangentY{ TransformVector(objectTangentX, objectTangentY, objectTangentZ, world[0].y, world[1].y, world[2].y) };
+				__m128 tangentZ{ TransformVector(objectTangentX, objectTangentY, objectTangentZ, world[0].z, world[1].z, world[2].z) };
+				Normalize(tangentX, tangentY, tangentZ);
+
+				//View direction from the camera to the world space position
+				const __m128 viewX{ _mm_sub_ps(TransformPoint(positionX, positionY, positionZ, world[0].x, world[1].x, world[2].x, world[3].x), _mm_set1_ps(input.cameraOrigin.x)) };
+				const __m128 viewY{ _mm_sub_ps(TransformPoint(positionX, positionY, positionZ, world[0].y, world[1].y, world[2].y, world[3].y), _mm_set1_ps(input.cameraOrigin.y)) };
+				const __m128 viewZ{ _mm_sub_ps(TransformPoint(positionX, positionY, positionZ, world[0].z, world[1].z, world[2].z, world[3].z), _mm_set1_ps(input.cameraOrigin.z)) };
+
+				//The output streams are one struct per vertex
+				alignas(16) float results[17][4];
+				_mm_store_ps(results[0], clipX);
+				_mm_store_ps(results[1], clipY);
+				_mm_store_ps(results[2], clipZ);
+				_mm_store_ps(results[3], clipW);
+				_mm_store_ps(results[4], rasterX);
+				_mm_store_ps(results[5], rasterY);
+				_mm_store_ps(results[6], depth);
+				_mm_store_ps(results[7], inverseW);
+				_mm_store_ps(results[8], normalX);
+				_mm_store_ps(results[9], normalY);
+				_mm_store_ps(results[10], normalZ);
+				_mm_store_ps(results[11], tangentX);
+				_mm_store_ps(results[12], tangentY);
+				_mm_store_ps(results[13], tangentZ);
+				_mm_store_ps(results[14], viewX);
+				_mm_store_ps(results[15], viewY);
+				_mm_store_ps(results[16], viewZ);
+
+				for (int lane{}; lane < 4; ++lane)
+				{
+					output.pPositionsClip[index + lane] = { results[0][lane], results[1][lane], results[2][lane], results[3][lane] };
+					output.pPositionsOut[index + lane] = { results[4][lane], results[5][lane], results[6][lane], results[7][lane] };
+					output.pNormals[index + lane] = { results[8][lane], results[9][lane], results[10][lane] };
+					output.pTangents[index + lane] = { results[11][lane], results[12][lane], results[13][lane] };
+					output.pViewDirections[index + lane] = { results[14][lane], results[15][lane], results[16][lane] };
+				}
+			}
+
+			TransformScalar(input, index, end - index, output);
+#else
+			TransformScalar(input, first, count, output);
+#endif
+		}
+	}
+}
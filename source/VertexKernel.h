@@ -0,0 +1,58 @@
+#pragma once
+
+//Standard includes
+#include <cstddef>
+
+//Project includes
+#include "Matrix.h"
+#include "RasterKernel.h"
+
+namespace dae
+{
+	//Vertex transform for a batch of vertices, reading one array per input component
+	//Every kernel does the same float operations in the same order as Matrix and Vector3, so they all produce the same vertices
+	namespace VertexKernel
+	{
+		struct TransformInput
+		{
+			//Object space positions, normals and tangents, one array per component
+			const float* pPositionX{};
+			const float* pPositionY{};
+			const float* pPositionZ{};
+			const float* pNormalX{};
+			const float* pNormalY{};
+			const float* pNormalZ{};
+			const float* pTangentX{};
+			const float* pTangentY{};
+			const float* pTangentZ{};
+
+			Matrix worldViewProjection{};
+			Matrix world{};
+			Vector3 cameraOrigin{};
+
+			//Render target size for the NDC -> raster mapping
+			float width{};
+			float height{};
+		};
+
+		struct TransformOutput
+		{
+			Vector4* pPositionsClip{};
+			Vector4* pPositionsOut{}; //Raster x and y, NDC depth and 1/w
+			Vector3* pNormals{};
+			Vector3* pTangents{};
+			Vector3* pViewDirections{};
+		};
+
+		//Transforms the vertices [first, first + count)
+		using TransformFunction = void(*)(const TransformInput& input, size_t first, size_t count, const TransformOutput& output);
+
+		TransformFunction GetTransformFunction(RasterKernel::InstructionSet instructionSet);
+
+		void TransformScalar(const TransformInput& input, size_t first, size_t count, const TransformOutput& output);
+		void TransformSSE2(const TransformInput& input, size_t first, size_t count, const TransformOutput& output);
+
+		//Compiled separately with AVX2 enabled, only call it when RasterKernel::DetectInstructionSet reports AVX2
+		void TransformAVX2(const TransformInput& input, size_t first, size_t count, const TransformOutput& output);
+	}
+}
@@ -0,0 +1,129 @@
+//This file is compiled with AVX2 enabled (/arch:AVX2, -mavx2), see RasterKernel::DetectInstructionSet
+#include "VertexKernel.h"
+
+//External includes
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace dae
+{
+	namespace VertexKernel
+	{
+#if defined(__AVX2__)
+		namespace
+		{
+			//Matrix::TransformPoint for one output component: m0 * x + m1 * y + m2 * z + m3
+			__m256 TransformPoint(__m256 x, __m256 y, __m256 z, float m0, float m1, float m2, float m3)
+			{
+				return _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m0), x), _mm256_mul_ps(_mm256_set1_ps(m1), y)), _mm256_mul_ps(_mm256_set1_ps(m2), z)), _mm256_set1_ps(m3));
+			}
+
+			//Matrix::TransformVector for one output component: m0 * x + m1 * y + m2 * z
+			__m256 TransformVector(__m256 x, __m256 y, __m256 z, float m0, float m1, float m2)
+			{
+				return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m0), x), _mm256_mul_ps(_mm256_set1_ps(m1), y)), _mm256_mul_ps(_mm256_set1_ps(m2), z));
+			}
+
+			//Vector3::Normalized
+			void Normalize(__m256& x, __m256& y, __m256& z)
+			{
+				const __m256 magnitude{ _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z))) };
+				x = _mm256_div_ps(x, magnitude);
+				y = _mm256_div_ps(y, magnitude);
+				z = _mm256_div_ps(z, magnitude);
+			}
+		}
+#endif
+
+		void TransformAVX2(const TransformInput& input, size_t first, size_t count, const TransformOutput& output)
+		{
+#if defined(__AVX2__)
+			const Matrix& worldViewProjection{ input.worldViewProjection };
+			const Matrix& world{ input.world };
+
+			const __m256 half{ _mm256_set1_ps(0.5f) };
+			const __m256 one{ _mm256_set1_ps(1.f) };
+
+			const size_t end{ first + count };
+			size_t index{ first };
+
+			for (; index + 8 <= end; index += 8)
+			{
+				const __m256 positionX{ _mm256_loadu_ps(input.pPositionX + index) };
+				const __m256 positionY{ _mm256_loadu_ps(input.pPositionY + index) };
+				const __m256 positionZ{ _mm256_loadu_ps(input.pPositionZ + index) };
+
+				//World view projection
+				const __m256 clipX{ TransformPoint(positionX, positionY, positionZ, worldViewProjection[0].x, worldViewProjection[1].x, worldViewProjection[2].x, worldViewProjection[3].x) };
+				const __m256 clipY{ TransformPoint(positionX, positionY, positionZ, worldViewProjection[0].y, worldViewProjection[1].y, worldViewProjection[2].y, worldViewProjection[3].y) };
+				const __m256 clipZ{ TransformPoint(positionX, positionY, positionZ, worldViewProjection[0].z, worldViewProjection[1].z, worldViewProjection[2].z, worldViewProjection[3].z) };
+				const __m256 clipW{ TransformPoint(positionX, positionY, positionZ, worldViewProjection[0].w, worldViewProjection[1].w, worldViewProjection[2].w, worldViewProjection[3].w) };
+
+				//Perspective divide and NDC -> raster space
+				const __m256 inverseW{ _mm256_div_ps(one, clipW) };
+				const __m256 rasterX{ _mm256_mul_ps(_mm256_mul_ps(half, _mm256_add_ps(_mm256_mul_ps(clipX, inverseW), one)), _mm256_set1_ps(input.width)) };
+				const __m256 rasterY{ _mm256_mul_ps(_mm256_mul_ps(half, _mm256_sub_ps(one, _mm256_mul_ps(clipY, inverseW))), _mm256_set1_ps(input.height)) };
+				const __m256 depth{ _mm256_mul_ps(clipZ, inverseW) };
+
+				//Normals and tangents to world space
+				const __m256 objectNormalX{ _mm256_loadu_ps(input.pNormalX + index) };
+				const __m256 objectNormalY{ _mm256_loadu_ps(input.pNormalY + index) };
+				const __m256 objectNormalZ{ _mm256_loadu_ps(input.pNormalZ + index) };
+
+				__m256 normalX{ TransformVector(objectNormalX, objectNormalY, objectNormalZ, world[0].x, world[1].x, world[2].x) };
+				__m256 normalY{ TransformVector(objectNormalX, objectNormalY, objectNormalZ, world[0].y, world[1].y, world[2].y) };
+				__m256 normalZ{ TransformVector(objectNormalX, objectNormalY, objectNormalZ, world[0].z, world[1].z, world[2].z) };
+				Normalize(normalX, normalY, normalZ);
+
+				const __m256 objectTangentX{ _mm256_loadu_ps(input.pTangentX + index) };
+				const __m256 objectTangentY{ _mm256_loadu_ps(input.pTangentY + index) };
+				const __m256 objectTangentZ{ _mm256_loadu_ps(input.pTangentZ + index) };
+
+				__m256 tangentX{ TransformVector(objectTangentX, objectTangentY, objectTangentZ, world[0].x, world[1].x, world[2].x) };
+				__m256 tangentY{ TransformVector(objectTangentX, objectTangentY, objectTangentZ, world[0].y, world[1].y, world[2].y) };
+				__m256 tangentZ{ TransformVector(objectTangentX, objectTangentY, objectTangentZ, world[0].z, world[1].z, world[2].z) };
+				Normalize(tangentX, tangentY, tangentZ);
+
+				//View direction from the camera to the world space position
+				const __m256 viewX{ _mm256_sub_ps(TransformPoint(positionX, positionY, positionZ, world[0].x, world[1].x, world[2].x, world[3].x), _mm256_set1_ps(input.cameraOrigin.x)) };
+				const __m256 viewY{ _mm256_sub_ps(TransformPoint(positionX, positionY, positionZ, world[0].y, world[1].y, world[2].y, world[3].y), _mm256_set1_ps(input.cameraOrigin.y)) };
+				const __m256 viewZ{ _mm256_sub_ps(TransformPoint(positionX, positionY, positionZ, world[0].z, world[1].z, world[2].z, world[3].z), _mm256_set1_ps(input.cameraOrigin.z)) };
+
+				//The output streams are one struct per vertex
+				alignas(32) float results[17][8];
+				_mm256_store_ps(results[0], clipX);
+				_mm256_store_ps(results[1], clipY);
+				_mm256_store_ps(results[2], clipZ);
+				_mm256_store_ps(results[3], clipW);
+				_mm256_store_ps(results[4], rasterX);
+				_mm256_store_ps(results[5], rasterY);
+				_mm256_store_ps(results[6], depth);
+				_mm256_store_ps(results[7], inverseW);
+				_mm256_store_ps(results[8], normalX);
+				_mm256_store_ps(results[9], normalY);
+				_mm256_store_ps(results[10], normalZ);
+				_mm256_store_ps(results[11], tangentX);
+				_mm256_store_ps(results[12], tangentY);
+				_mm256_store_ps(results[13], tangentZ);
+				_mm256_store_ps(results[14], viewX);
+				_mm256_store_ps(results[15], viewY);
+				_mm256_store_ps(results[16], viewZ);
+
+				for (int lane{}; lane < 8; ++lane)
+				{
+					output.pPositionsClip[index + lane] = { results[0][lane], results[1][lane], results[2][lane], results[3][lane] };
+					output.pPositionsOut[index + lane] = { results[4][lane], results[5][lane], results[6][lane], results[7][lane] };
+					output.pNormals[index + lane] = { results[8][lane], results[9][lane], results[10][lane] };
+					output.pTangents[index + lane] = { results[11][lane], results[12][lane], results[13][lane] };
+					output.pViewDirections[index + lane] = { results[14][lane], results[15][lane], results[16][lane] };
+				}
+			}
+
+			TransformScalar(input, index, end - index, output);
+#else
+			TransformScalar(input, first, count, output);
+#endif
+		}
+	}
+}
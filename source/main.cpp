@@ -6,10 +6,12 @@
 
 //Standard includes
 #include <iostream>
+#include <string>
 
 //Project includes
 #include "Timer.h"
 #include "Renderer.h"
+#include "RenderTarget.h"
 
 using namespace dae;
 
@@ -42,7 +44,36 @@ int main(int argc, char* args[])
 
 	//Initialize "framework"
 	const auto pTimer = new Timer();
-	const auto pRenderer = new Renderer(pWindow);
+	const auto pRenderTarget = new WindowRenderTarget(pWindow);
+	const auto pRenderer = new Renderer(pRenderTarget);
+
+	//Load the scene
+	const std::string meshPath{ "Resources/vehicle.obj" };
+	std::string failedPath{ meshPath };
+	if (!pRenderer->LoadMesh(meshPath) ||
+		!pRenderer->LoadMaterial({ "Resources/vehicle_diffuse.png", "Resources/vehicle_normal.png", "Resources/vehicle_gloss.png", "Resources/vehicle_specular.png" }, failedPath))
+	{
+		std::cout << "Could not load " << failedPath << std::endl;
+
+		delete pRenderer;
+		delete pRenderTarget;
+		delete pTimer;
+
+		ShutDown(pWindow);
+		return 1;
+	}
+
+	const MeshStatistics& meshStatistics{ pRenderer->GetMeshStatistics() };
+	std::cout << "Mesh: " << meshStatistics.nrIndices << " face corners -> " << meshStatistics.nrVertices << " vertices ("
+		<< static_cast<float>(meshStatistics.nrIndices) / meshStatistics.nrVertices << "x reduction), ACMR "
+		<< meshStatistics.loadedACMR << " -> " << meshStatistics.optimizedACMR << ", " << meshStatistics.nrMeshlets << " meshlets" << std::endl;
+
+	std::cout << "Levels of detail:";
+	for (size_t lod{}; lod < meshStatistics.nrLodTriangles.size(); ++lod)
+	{
+		std::cout << " " << meshStatistics.nrLodTriangles[lod] << " triangles (error " << meshStatistics.lodErrors[lod] << ")";
+	}
+	std::cout << std::endl;
 
 	//Start loop
 	pTimer->Start();
@@ -67,6 +98,16 @@ int main(int argc, char* args[])
 					pRenderer->ToggleRotation();
 				if (e.key.keysym.scancode == SDL_SCANCODE_F6)
 					pRenderer->ToggleNormalMap();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F7)
+					pRenderer->ToggleVisibilityBuffer();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F8)
+					pRenderer->ToggleCullMode();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F9)
+					pRenderer->ToggleLods();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F10)
+					pRenderer->ToggleMaterialMode();
+				if (e.key.keysym.scancode == SDL_SCANCODE_F11)
+					pRenderer->ToggleMipmaps();
 				if (e.key.keysym.scancode == SDL_SCANCODE_X)
 					takeScreenshot = true;
 				break;
@@ -102,6 +143,7 @@ int main(int argc, char* args[])
 
 	//Shutdown "framework"
 	delete pRenderer;
+	delete pRenderTarget;
 	delete pTimer;
 
 	ShutDown(pWindow);